@@ -0,0 +1,112 @@
+#include "bench.h"
+#include "codec.h"
+
+#include <windows.h>
+#include <psapi.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Decodes a synthetic 1M-entry checkpoint plaintext into an EntryTable, as
+// unlock does, and into the std::vector<Entry> it replaced, and reports the
+// decode time and the working set each adds per entry. Each layout runs in
+// a child process of its own so one cannot reuse the heap the other freed.
+// Sealing and the KDF are left out.
+namespace {
+    const size_t kEntries = 1000000;
+
+    size_t WorkingSet() {
+        PROCESS_MEMORY_COUNTERS counters{};
+        counters.cb = sizeof(counters);
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.WorkingSetSize;
+    }
+
+    void Checkpoint(std::vector<unsigned char>& out) {
+        std::mt19937 rng(17);
+        std::vector<unsigned char> wrapped(60);
+        for (auto& b : wrapped) b = (unsigned char)rng();
+        codec::WriteVaultHeader(wrapped, kEntries, out);
+        codec::Writer w(out);
+        for (size_t i = 0; i < kEntries; ++i) codec::WriteEntry(w, bench::MakeEntry(rng, i + 1));
+    }
+
+    bool DecodeTable(const std::vector<codec::EntryView>& views, EntryTable& table) {
+        size_t chars = 0;
+        size_t sealed = 0;
+        for (const auto& view : views) {
+            chars += view.title.size + view.category.size + view.username.size + view.url.size;
+            sealed += view.secrets.size;
+        }
+        table.Reserve(views.size(), chars, sealed);
+        Entry e;
+        for (const auto& view : views) {
+            if (!codec::Materialize(view, e)) return false;
+            table.Append(e);
+        }
+        return true;
+    }
+
+    bool DecodeVector(const std::vector<codec::EntryView>& views, std::vector<Entry>& entries) {
+        entries.reserve(views.size());
+        for (const auto& view : views) {
+            Entry e;
+            if (!codec::Materialize(view, e)) return false;
+            entries.push_back(std::move(e));
+        }
+        return true;
+    }
+
+    int Run(bool table) {
+        std::vector<unsigned char> plain;
+        Checkpoint(plain);
+        codec::Bytes wrapped;
+        std::vector<codec::EntryView> views;
+        if (!codec::ReadVault(plain.data(), plain.size(), wrapped, views) || views.size() != kEntries) {
+            printf("FAIL checkpoint\n");
+            return 1;
+        }
+
+        EntryTable arena;
+        std::vector<Entry> entries;
+        const size_t before = WorkingSet();
+        bool ok = false;
+        double ms = bench::BestMs(1, [&]() {
+            ok = table ? DecodeTable(views, arena) : DecodeVector(views, entries);
+        });
+        const size_t after = WorkingSet();
+        if (!ok) {
+            printf("FAIL decode\n");
+            return 1;
+        }
+        printf("%-20s decode %7.1f ms  %6.1f bytes/entry resident\n",
+            table ? "EntryTable" : "std::vector<Entry>", ms, (double)(after - before) / kEntries);
+        return 0;
+    }
+
+    int RunChild(const wchar_t* mode) {
+        wchar_t self[MAX_PATH];
+        if (!GetModuleFileNameW(nullptr, self, MAX_PATH)) return 1;
+        std::wstring command = L"\"" + std::wstring(self) + L"\" " + mode;
+        STARTUPINFOW si{};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi{};
+        if (!CreateProcessW(nullptr, &command[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) return 1;
+        WaitForSingleObject(pi.hProcess, INFINITE);
+        DWORD code = 1;
+        GetExitCodeProcess(pi.hProcess, &code);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+        return (int)code;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) return Run(strcmp(argv[1], "table") == 0);
+    printf("%zu entries\n", kEntries);
+    fflush(stdout);
+    int failed = RunChild(L"vector");
+    failed |= RunChild(L"table");
+    return failed;
+}
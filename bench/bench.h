@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <string>
+
+#include "entries.h"
+
+// Shared pieces of the benchmark programs: a timer that keeps the best of
+// several runs, and a generator of vault-like entries.
+namespace bench {
+    template <typename Fn>
+    double BestMs(int runs, Fn fn) {
+        double best = 1e300;
+        for (int i = 0; i < runs; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+        return best;
+    }
+
+    inline std::wstring Word(std::mt19937& rng, int minLen, int maxLen) {
+        int len = minLen + (int)(rng() % (unsigned)(maxLen - minLen + 1));
+        std::wstring out;
+        for (int i = 0; i < len; ++i) out.push_back((wchar_t)(L'a' + rng() % 26));
+        return out;
+    }
+
+    // Titles, logins and urls of typical lengths, five categories and a
+    // stand-in for the sealed secrets of a short password and note.
+    inline Entry MakeEntry(std::mt19937& rng, uint64_t id) {
+        static const wchar_t* const kCategories[] = { L"Работа", L"Почта", L"Банк", L"Игры", L"Соцсети" };
+        Entry e;
+        e.id = id;
+        e.title = Word(rng, 6, 24);
+        e.category = kCategories[rng() % 5];
+        e.username = Word(rng, 6, 20) + L"@example.com";
+        e.url = L"https://" + Word(rng, 5, 15) + L".com/login";
+        e.secrets.resize(60 + rng() % 40);
+        for (auto& b : e.secrets) b = (unsigned char)rng();
+        return e;
+    }
+}
@@ -0,0 +1,227 @@
+#include "bench.h"
+#include "codec.h"
+
+#include <windows.h>
+#include <cstdio>
+#include <cwchar>
+#include <vector>
+
+// Encodes and decodes a 100k-entry checkpoint plaintext with the binary
+// codec and with the tab-escaped text serializer it replaced, kept here as
+// it was. Sealing is left out: both paths seal the same number of bytes
+// give or take the text layout's hex overhead.
+namespace {
+    const size_t kEntries = 100000;
+    const int kRuns = 5;
+
+    namespace text {
+        const wchar_t kFormatTag[] = L"@v2";
+
+        std::wstring Escape(const std::wstring& s) {
+            std::wstring out;
+            out.reserve(s.size());
+            for (wchar_t c : s) {
+                if (c == L'\\' || c == L'\t' || c == L'\n') out.push_back(L'\\');
+                if (c == L'\t') out.push_back(L't');
+                else if (c == L'\n') out.push_back(L'n');
+                else out.push_back(c);
+            }
+            return out;
+        }
+
+        std::wstring Unescape(const std::wstring& s) {
+            std::wstring out;
+            out.reserve(s.size());
+            bool esc = false;
+            for (wchar_t c : s) {
+                if (!esc && c == L'\\') {
+                    esc = true;
+                    continue;
+                }
+                if (esc) {
+                    if (c == L't') out.push_back(L'\t');
+                    else if (c == L'n') out.push_back(L'\n');
+                    else out.push_back(c);
+                    esc = false;
+                } else {
+                    out.push_back(c);
+                }
+            }
+            return out;
+        }
+
+        std::vector<unsigned char> ToUtf8(const std::wstring& w) {
+            if (w.empty()) return {};
+            int len = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
+            std::vector<unsigned char> out(len);
+            WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), (LPSTR)out.data(), len, nullptr, nullptr);
+            return out;
+        }
+
+        std::wstring FromUtf8(const std::vector<unsigned char>& data) {
+            if (data.empty()) return L"";
+            int len = MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)data.data(), (int)data.size(), nullptr, 0);
+            std::wstring out(len, L'\0');
+            MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)data.data(), (int)data.size(), out.data(), len);
+            return out;
+        }
+
+        std::wstring ToHex(const std::vector<unsigned char>& bytes) {
+            static const wchar_t digits[] = L"0123456789abcdef";
+            std::wstring out;
+            out.reserve(bytes.size() * 2);
+            for (unsigned char b : bytes) {
+                out.push_back(digits[b >> 4]);
+                out.push_back(digits[b & 0xF]);
+            }
+            return out;
+        }
+
+        bool FromHex(const wchar_t* s, size_t len, std::vector<unsigned char>& out) {
+            auto nibble = [](wchar_t c) -> int {
+                if (c >= L'0' && c <= L'9') return c - L'0';
+                if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+                return -1;
+            };
+            if (len % 2 != 0) return false;
+            out.resize(len / 2);
+            for (size_t i = 0; i < out.size(); ++i) {
+                int hi = nibble(s[2 * i]);
+                int lo = nibble(s[2 * i + 1]);
+                if (hi < 0 || lo < 0) return false;
+                out[i] = (unsigned char)((hi << 4) | lo);
+            }
+            return true;
+        }
+
+        std::vector<std::wstring> SplitFields(const std::wstring& line) {
+            std::vector<std::wstring> out;
+            size_t start = 0;
+            while (true) {
+                size_t tab = line.find(L'\t', start);
+                if (tab == std::wstring::npos) {
+                    out.push_back(line.substr(start));
+                    return out;
+                }
+                out.push_back(line.substr(start, tab - start));
+                start = tab + 1;
+            }
+        }
+
+        void AppendLine(const Entry& e, std::wstring& text) {
+            text += Escape(e.title) + L"\t" +
+                Escape(e.category) + L"\t" +
+                Escape(e.username) + L"\t" +
+                Escape(e.url) + L"\t" +
+                std::to_wstring(e.id) + L"\t" +
+                ToHex(e.secrets);
+        }
+
+        bool ParseLine(const std::wstring& line, Entry& e) {
+            std::vector<std::wstring> f = SplitFields(line);
+            if (f.size() != 6) return false;
+            e.title = Unescape(f[0]);
+            e.category = Unescape(f[1]);
+            e.username = Unescape(f[2]);
+            e.url = Unescape(f[3]);
+            e.id = wcstoull(f[4].c_str(), nullptr, 10);
+            return FromHex(f[5].c_str(), f[5].size(), e.secrets);
+        }
+
+        std::vector<unsigned char> Serialize(const std::vector<unsigned char>& wrapped, const std::vector<Entry>& entries) {
+            std::wstring text = kFormatTag;
+            text += L"\t" + ToHex(wrapped) + L"\n";
+            for (const auto& e : entries) {
+                AppendLine(e, text);
+                text += L"\n";
+            }
+            return ToUtf8(text);
+        }
+
+        bool Deserialize(const std::vector<unsigned char>& bytes, std::vector<unsigned char>& wrapped, std::vector<Entry>& entries) {
+            std::wstring text = FromUtf8(bytes);
+            size_t end = text.find(L'\n');
+            if (end == std::wstring::npos) return false;
+            std::wstring first = text.substr(0, end);
+            const size_t tagLen = wcslen(kFormatTag);
+            if (first.compare(0, tagLen, kFormatTag) != 0 || first.size() <= tagLen) return false;
+            if (!FromHex(first.c_str() + tagLen + 1, first.size() - tagLen - 1, wrapped)) return false;
+            size_t start = end + 1;
+            while (start < text.size()) {
+                end = text.find(L'\n', start);
+                if (end == std::wstring::npos) end = text.size();
+                std::wstring line = text.substr(start, end - start);
+                Entry e;
+                if (ParseLine(line, e)) entries.push_back(std::move(e));
+                start = end + 1;
+            }
+            return true;
+        }
+    }
+
+    void Encode(const std::vector<unsigned char>& wrapped, const EntryTable& table, std::vector<unsigned char>& out) {
+        out.clear();
+        codec::WriteVaultHeader(wrapped, table.Size(), out);
+        codec::Writer w(out);
+        for (size_t i = 0; i < table.Size(); ++i) codec::WriteEntry(w, table[i]);
+    }
+
+    // As vault::Store decodes a checkpoint: views first, then one reused
+    // scratch entry copied into arenas sized from the encoded lengths.
+    bool Decode(const std::vector<unsigned char>& bytes, EntryTable& table) {
+        codec::Bytes wrapped;
+        std::vector<codec::EntryView> views;
+        if (!codec::ReadVault(bytes.data(), bytes.size(), wrapped, views)) return false;
+        size_t chars = 0;
+        size_t sealed = 0;
+        for (const auto& view : views) {
+            chars += view.title.size + view.category.size + view.username.size + view.url.size;
+            sealed += view.secrets.size;
+        }
+        table.Clear();
+        table.Reserve(views.size(), chars, sealed);
+        Entry e;
+        for (const auto& view : views) {
+            if (!codec::Materialize(view, e)) return false;
+            table.Append(e);
+        }
+        return true;
+    }
+}
+
+int main() {
+    std::mt19937 rng(6);
+    std::vector<unsigned char> wrapped(60);
+    for (auto& b : wrapped) b = (unsigned char)rng();
+    std::vector<Entry> entries;
+    EntryTable table;
+    entries.reserve(kEntries);
+    for (size_t i = 0; i < kEntries; ++i) {
+        entries.push_back(bench::MakeEntry(rng, i + 1));
+        table.Append(entries.back());
+    }
+
+    std::vector<unsigned char> oldBytes;
+    double oldWrite = bench::BestMs(kRuns, [&]() { oldBytes = text::Serialize(wrapped, entries); });
+    bool oldOk = true;
+    double oldRead = bench::BestMs(kRuns, [&]() {
+        std::vector<unsigned char> key;
+        std::vector<Entry> parsed;
+        oldOk = text::Deserialize(oldBytes, key, parsed) && parsed.size() == kEntries && oldOk;
+    });
+
+    std::vector<unsigned char> newBytes;
+    double newWrite = bench::BestMs(kRuns, [&]() { Encode(wrapped, table, newBytes); });
+    bool newOk = true;
+    EntryTable parsed;
+    double newRead = bench::BestMs(kRuns, [&]() { newOk = Decode(newBytes, parsed) && parsed.Size() == kEntries && newOk; });
+
+    printf("%zu entries\n", kEntries);
+    printf("text serializer: write %8.1f ms  read %8.1f ms  %zu bytes\n", oldWrite, oldRead, oldBytes.size());
+    printf("binary codec:    write %8.1f ms  read %8.1f ms  %zu bytes\n", newWrite, newRead, newBytes.size());
+    if (!oldOk || !newOk) {
+        printf("FAIL round trip\n");
+        return 1;
+    }
+    return 0;
+}
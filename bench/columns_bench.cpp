@@ -0,0 +1,81 @@
+#include "bench.h"
+#include "match.h"
+
+#include <cstdio>
+#include <vector>
+
+// Runs three single-field scans over 1M entries held as std::vector<Entry>,
+// as the row-per-entry EntryTable the vault uses, and as EntryColumns:
+// a category compare, a username substring search and a sum over the
+// sealed secrets' sizes.
+namespace {
+    const size_t kEntries = 1000000;
+    const int kRuns = 5;
+
+    struct Counts {
+        size_t category = 0;
+        size_t username = 0;
+        size_t secrets = 0;
+
+        bool operator==(const Counts& o) const {
+            return category == o.category && username == o.username && secrets == o.secrets;
+        }
+    };
+
+    template <typename Category, typename Username, typename Secrets>
+    Counts Scan(const char* name, size_t count, Category category, Username username, Secrets secrets) {
+        const std::wstring_view bank = L"Банк";
+        const search::Pattern pattern(L"qzx");
+        Counts c;
+        double a = bench::BestMs(kRuns, [&]() {
+            c.category = 0;
+            for (size_t i = 0; i < count; ++i) c.category += category(i) == bank;
+        });
+        double b = bench::BestMs(kRuns, [&]() {
+            c.username = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const std::wstring_view u = username(i);
+                c.username += search::Contains(u.data(), u.size(), pattern);
+            }
+        });
+        double s = bench::BestMs(kRuns, [&]() {
+            c.secrets = 0;
+            for (size_t i = 0; i < count; ++i) c.secrets += secrets(i);
+        });
+        printf("%-20s category %6.1f ms  username %6.1f ms  secrets %6.1f ms\n", name, a, b, s);
+        return c;
+    }
+}
+
+int main() {
+    std::mt19937 rng(18);
+    std::vector<Entry> entries;
+    EntryTable table;
+    entries.reserve(kEntries);
+    for (size_t i = 0; i < kEntries; ++i) {
+        entries.push_back(bench::MakeEntry(rng, i + 1));
+        table.Append(entries.back());
+    }
+    EntryColumns columns;
+    double build = bench::BestMs(1, [&]() { columns.Build(table); });
+
+    printf("%zu entries\n", kEntries);
+    const Counts structs = Scan("std::vector<Entry>", entries.size(),
+        [&](size_t i) { return std::wstring_view(entries[i].category); },
+        [&](size_t i) { return std::wstring_view(entries[i].username); },
+        [&](size_t i) { return entries[i].secrets.size(); });
+    const Counts rows = Scan("EntryTable", table.Size(),
+        [&](size_t i) { return table[i].category; },
+        [&](size_t i) { return table[i].username; },
+        [&](size_t i) { return table[i].secrets.size; });
+    const Counts cols = Scan("EntryColumns", columns.Size(),
+        [&](size_t i) { return columns.Text(EntryColumns::kCategory, i); },
+        [&](size_t i) { return columns.Text(EntryColumns::kUsername, i); },
+        [&](size_t i) { return columns.Secrets(i).size; });
+    printf("EntryColumns::Build %.1f ms\n", build);
+    if (!(structs == rows) || !(rows == cols)) {
+        printf("FAIL layouts disagree\n");
+        return 1;
+    }
+    return 0;
+}
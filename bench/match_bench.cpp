@@ -0,0 +1,86 @@
+#include "bench.h"
+#include "match.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cwctype>
+#include <vector>
+
+// Filters 100k mixed-case Latin and Cyrillic strings with search::Contains,
+// with each of its scanners, and with the ContainsI the vault filter used
+// before: lowercase copies of both strings through towlower, then find.
+// towlower follows the CRT locale, so its hit counts on Cyrillic can
+// differ; only the scanners are required to agree.
+namespace {
+    const size_t kStrings = 100000;
+    const size_t kLength = 80;
+    const int kRuns = 5;
+
+    std::wstring ToLower(const std::wstring& s) {
+        std::wstring out = s;
+        std::transform(out.begin(), out.end(), out.begin(), towlower);
+        return out;
+    }
+
+    bool ContainsI(const std::wstring& hay, const std::wstring& needle) {
+        if (needle.empty()) return true;
+        std::wstring h = ToLower(hay);
+        std::wstring n = ToLower(needle);
+        return h.find(n) != std::wstring::npos;
+    }
+}
+
+int main() {
+    static const wchar_t kLetters[] = L"абвгдеёжзийклмнопрстуфхцчшщъыьэюяАБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯabcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ .@";
+    const size_t letterCount = sizeof(kLetters) / sizeof(kLetters[0]) - 1;
+    std::mt19937 rng(12);
+    std::vector<std::wstring> hay(kStrings);
+    for (auto& s : hay) {
+        for (size_t i = 0; i < kLength; ++i) s.push_back(kLetters[rng() % letterCount]);
+    }
+    struct Query {
+        const char* label;
+        std::wstring text;
+    };
+    const Query queries[] = {
+        { "cyrillic", L"Банк" },
+        { "latin", L"mail" },
+        { "mixed, no hits", L"пароль123" },
+    };
+
+    bool same = true;
+    for (const Query& query : queries) {
+        const std::wstring& needle = query.text;
+        size_t oldHits = 0;
+        double oldMs = bench::BestMs(kRuns, [&]() {
+            oldHits = 0;
+            for (const auto& s : hay) oldHits += ContainsI(s, needle);
+        });
+        const search::Pattern pattern(needle);
+        size_t newHits = 0;
+        double newMs = bench::BestMs(kRuns, [&]() {
+            newHits = 0;
+            for (const auto& s : hay) newHits += search::Contains(s, pattern);
+        });
+        printf("%-15s ContainsI %7.1f ms (%zu hits)  Contains %6.1f ms", query.label, oldMs, oldHits, newMs);
+
+        const search::Scanner scanners[] = { search::Scanner::kScalar, search::Scanner::kSse2, search::Scanner::kAvx2 };
+        const char* const names[] = { "scalar", "sse2", "avx2" };
+        for (int k = 0; k < 3; ++k) {
+            if (!search::Supported(scanners[k])) continue;
+            size_t hits = 0;
+            double ms = bench::BestMs(kRuns, [&]() {
+                hits = 0;
+                for (const auto& s : hay) hits += search::ContainsWith(scanners[k], s.data(), s.size(), pattern);
+            });
+            printf("  %s %6.1f ms", names[k], ms);
+            same = same && hits == newHits;
+        }
+        printf("  (%zu hits)\n", newHits);
+    }
+    if (!same) {
+        printf("FAIL scanners disagree\n");
+        return 1;
+    }
+    return 0;
+}
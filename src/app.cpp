@@ -1,4 +1,5 @@
 #include "app.h"
+#include "attachments.h"
 
 #ifndef _WIN32_IE
 #define _WIN32_IE 0x0600
@@ -6,6 +7,10 @@
 #include "ui_controls.h"
 #include "theme.h"
 #include "password_gen.h"
+#include "strength.h"
+#include "audit.h"
+#include "breach.h"
+#include "csv_import.h"
 
 #include <commctrl.h>
 #include <dwmapi.h>
@@ -15,6 +20,7 @@
 #include <fstream>
 #include <locale>
 #include <codecvt>
+#include <ctime>
 #include <vector>
 
 #pragma comment(lib, "comctl32.lib")
@@ -23,6 +29,12 @@ namespace {
     const int kNavWidth = 220;
     const int kTopPad = 24;
     const int kPad = 16;
+    const UINT WM_SAVED = WM_APP + 1;
+    const UINT WM_BREACH_BUILT = WM_APP + 2;
+    const UINT WM_IMPORTED = WM_APP + 3;
+    const size_t kMaxResults = 500;
+    const size_t kMaxAuditTitles = 50;
+    const size_t kMaxImportProblems = 20;
 
     enum {
         ID_NAV_VAULT = 100,
@@ -41,9 +53,15 @@ namespace {
         ID_IMPORT = 309,
         ID_EXPORT = 310,
         ID_AUTOFILL = 311,
+        ID_ATTACH = 312,
+        ID_SAVE_ATTACH = 313,
+        ID_DETACH = 314,
+        ID_PASS = 315,
         ID_GEN = 400,
         ID_COPY = 401,
-        ID_SET = 500
+        ID_SET = 500,
+        ID_AUDIT = 501,
+        ID_BREACH = 502
     };
 
     HFONT g_title = nullptr;
@@ -68,58 +86,16 @@ namespace {
         return CallWindowProcW(g_editProc, hwnd, msg, wParam, lParam);
     }
 
-    std::wstring ToLower(const std::wstring& s) {
-        std::wstring out = s;
-        std::transform(out.begin(), out.end(), out.begin(), towlower);
-        return out;
-    }
-
-    bool ContainsI(const std::wstring& hay, const std::wstring& needle) {
-        if (needle.empty()) return true;
-        std::wstring h = ToLower(hay);
-        std::wstring n = ToLower(needle);
-        return h.find(n) != std::wstring::npos;
-    }
-
-    int GetSelectedEntryIndex(HWND list) {
+    int GetSelectedEntryIndex(HWND list, const view::VaultView& rows) {
         int sel = ListView_GetNextItem(list, -1, LVNI_SELECTED);
         if (sel < 0) return -1;
-        LVITEMW item{};
-        item.iItem = sel;
-        item.mask = LVIF_PARAM;
-        if (ListView_GetItem(list, &item)) {
-            return (int)item.lParam;
-        }
-        return -1;
-    }
-
-    std::vector<std::wstring> CsvSplit(const std::wstring& line) {
-        std::vector<std::wstring> out;
-        std::wstring cur;
-        bool inQuotes = false;
-        for (size_t i = 0; i < line.size(); ++i) {
-            wchar_t c = line[i];
-            if (c == L'"') {
-                if (inQuotes && i + 1 < line.size() && line[i + 1] == L'"') {
-                    cur.push_back(L'"');
-                    ++i;
-                } else {
-                    inQuotes = !inQuotes;
-                }
-            } else if (c == L',' && !inQuotes) {
-                out.push_back(cur);
-                cur.clear();
-            } else {
-                cur.push_back(c);
-            }
-        }
-        out.push_back(cur);
-        return out;
+        size_t pos = rows.Position((size_t)sel);
+        return pos == view::VaultView::kNoRow ? -1 : (int)pos;
     }
 
-    std::wstring CsvEscape(const std::wstring& s) {
+    std::wstring CsvEscape(std::wstring_view s) {
         bool need = s.find_first_of(L",\"\n") != std::wstring::npos;
-        if (!need) return s;
+        if (!need) return std::wstring(s);
         std::wstring out = L"\"";
         for (wchar_t c : s) {
             if (c == L'"') out += L"\"\"";
@@ -128,6 +104,26 @@ namespace {
         out += L"\"";
         return out;
     }
+
+    void AppendTitles(const Vault& v, const std::vector<size_t>& positions, std::wstring& out) {
+        for (size_t i = 0; i < positions.size() && i < kMaxAuditTitles; ++i) {
+            const std::wstring_view title = v.entries[positions[i]].title;
+            out += i == 0 ? L"    " : L", ";
+            out += title.empty() ? std::wstring_view(L"(без названия)") : title;
+        }
+        if (positions.size() > kMaxAuditTitles) out += L" и ещё " + std::to_wstring(positions.size() - kMaxAuditTitles);
+        if (!positions.empty()) out += L"\r\n";
+    }
+
+    void AppendSection(const Vault& v, const wchar_t* name, const std::vector<size_t>& positions, std::wstring& out) {
+        out += name;
+        out += L": " + std::to_wstring(positions.size()) + L"\r\n";
+        AppendTitles(v, positions, out);
+    }
+
+    void ShowSaveFailed(HWND owner) {
+        MessageBoxW(owner, L"Не удалось сохранить изменения.", L"LusaKey", MB_OK | MB_ICONERROR);
+    }
 }
 
 bool MainWindow::Create() {
@@ -241,7 +237,7 @@ void MainWindow::BuildHomePage() {
     btnExport_ = ui::CreateRoundedButton(homePage_, ID_EXPORT, L"Экспорт CSV", kNavWidth + 600, 66, 130, 32);
 
     listVault_ = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, L"",
-        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL, kNavWidth + 40, 110, 500, 480,
+        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | LVS_OWNERDATA, kNavWidth + 40, 110, 500, 480,
         homePage_, (HMENU)ID_VAULT_LIST, GetModuleHandleW(nullptr), nullptr);
     ApplyFont(listVault_, g_body);
 
@@ -286,7 +282,7 @@ void MainWindow::BuildHomePage() {
         760, 270, 160, 20, homePage_, nullptr, GetModuleHandleW(nullptr), nullptr);
     editPass_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
         WS_CHILD | WS_VISIBLE | ES_PASSWORD, 760, 290, 260, 28,
-        homePage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+        homePage_, (HMENU)ID_PASS, GetModuleHandleW(nullptr), nullptr);
 
     lblUrl_ = CreateWindowExW(0, L"STATIC", L"Сайт", WS_CHILD | WS_VISIBLE,
         760, 330, 160, 20, homePage_, nullptr, GetModuleHandleW(nullptr), nullptr);
@@ -297,8 +293,17 @@ void MainWindow::BuildHomePage() {
     lblNotes_ = CreateWindowExW(0, L"STATIC", L"Заметки", WS_CHILD | WS_VISIBLE,
         760, 390, 160, 20, homePage_, nullptr, GetModuleHandleW(nullptr), nullptr);
     editNotes_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
-        WS_CHILD | WS_VISIBLE | ES_MULTILINE, 760, 410, 260, 90,
+        WS_CHILD | WS_VISIBLE | ES_MULTILINE, 760, 410, 260, 50,
+        homePage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+
+    listAttach_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"COMBOBOX", L"",
+        WS_CHILD | WS_VISIBLE | CBS_DROPDOWNLIST, 760, 470, 140, 200,
         homePage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+    btnAttach_ = ui::CreateRoundedButton(homePage_, ID_ATTACH, L"+", 906, 468, 34, 30);
+    btnSaveAttach_ = ui::CreateRoundedButton(homePage_, ID_SAVE_ATTACH, L"↓", 946, 468, 34, 30);
+    btnDetach_ = ui::CreateRoundedButton(homePage_, ID_DETACH, L"×", 986, 468, 34, 30);
+    ui::SetButtonAccent(btnSaveAttach_, false);
+    ui::SetButtonAccent(btnDetach_, false);
 
     btnCopyUser_ = ui::CreateRoundedButton(homePage_, ID_COPY_USER, L"Копировать логин", 760, 510, 120, 34);
     btnCopyPass_ = ui::CreateRoundedButton(homePage_, ID_COPY_PASS, L"Копировать пароль", 900, 510, 120, 34);
@@ -320,6 +325,7 @@ void MainWindow::BuildHomePage() {
     ApplyFont(editPass_, g_body);
     ApplyFont(editUrl_, g_body);
     ApplyFont(editNotes_, g_body);
+    ApplyFont(listAttach_, g_body);
 
     RECT rc;
     GetClientRect(hwnd_, &rc);
@@ -340,6 +346,18 @@ void MainWindow::BuildGeneratorPage() {
         WS_CHILD | WS_VISIBLE, kNavWidth + 40, 112, 80, 28,
         generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
 
+    CreateWindowExW(0, L"STATIC", L"Разделитель", WS_CHILD | WS_VISIBLE,
+        kNavWidth + 200, 90, 120, 20, generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+    genSeparator_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"-",
+        WS_CHILD | WS_VISIBLE, kNavWidth + 200, 112, 80, 28,
+        generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+    genPhrase_ = CreateWindowExW(0, L"BUTTON", L"Фраза из слов", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+        kNavWidth + 200, 160, 180, 24, generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+    genSimilar_ = CreateWindowExW(0, L"BUTTON", L"Без похожих символов", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+        kNavWidth + 200, 190, 200, 24, generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+    genEach_ = CreateWindowExW(0, L"BUTTON", L"Из каждого набора", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+        kNavWidth + 200, 220, 200, 24, generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+
     genLower_ = CreateWindowExW(0, L"BUTTON", L"Строчные", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
         kNavWidth + 40, 160, 140, 24, generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
     genUpper_ = CreateWindowExW(0, L"BUTTON", L"Прописные", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
@@ -356,6 +374,9 @@ void MainWindow::BuildGeneratorPage() {
         WS_CHILD | WS_VISIBLE | ES_READONLY, kNavWidth + 40, 300, 360, 32,
         generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
 
+    genEntropy_ = CreateWindowExW(0, L"STATIC", L"", WS_CHILD | WS_VISIBLE,
+        kNavWidth + 40, 400, 360, 20, generatorPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+
     genBtn_ = ui::CreateRoundedButton(generatorPage_, ID_GEN, L"Сгенерировать", kNavWidth + 40, 350, 140, 38);
     genCopy_ = ui::CreateRoundedButton(generatorPage_, ID_COPY, L"Копировать", kNavWidth + 200, 350, 140, 38);
     ui::SetButtonAccent(genCopy_, false);
@@ -365,7 +386,12 @@ void MainWindow::BuildGeneratorPage() {
     ApplyFont(genUpper_, g_body);
     ApplyFont(genDigits_, g_body);
     ApplyFont(genSymbols_, g_body);
+    ApplyFont(genSeparator_, g_body);
+    ApplyFont(genPhrase_, g_body);
+    ApplyFont(genSimilar_, g_body);
+    ApplyFont(genEach_, g_body);
     ApplyFont(genOut_, g_body);
+    ApplyFont(genEntropy_, g_body);
 }
 
 void MainWindow::BuildSettingsPage() {
@@ -390,8 +416,29 @@ void MainWindow::BuildSettingsPage() {
 
     setBtn_ = ui::CreateRoundedButton(settingsPage_, ID_SET, L"Обновить мастер‑пароль", kNavWidth + 40, 220, 260, 40);
 
+    CreateWindowExW(0, L"STATIC", L"Проверка паролей",
+        WS_CHILD | WS_VISIBLE, kNavWidth + 40, 290, 360, 28,
+        settingsPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+    auditBtn_ = ui::CreateRoundedButton(settingsPage_, ID_AUDIT, L"Проверить пароли", kNavWidth + 40, 326, 260, 40);
+    auditOut_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
+        WS_CHILD | WS_VISIBLE | WS_VSCROLL | ES_MULTILINE | ES_READONLY, kNavWidth + 40, 380, 520, 240,
+        settingsPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+
+    CreateWindowExW(0, L"STATIC", L"Утечки паролей",
+        WS_CHILD | WS_VISIBLE, kNavWidth + 580, 290, 260, 28,
+        settingsPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+    breachBtn_ = ui::CreateRoundedButton(settingsPage_, ID_BREACH, L"Выбрать базу…", kNavWidth + 580, 326, 260, 40);
+    breachStatus_ = CreateWindowExW(0, L"STATIC", L"",
+        WS_CHILD | WS_VISIBLE, kNavWidth + 580, 380, 260, 60,
+        settingsPage_, nullptr, GetModuleHandleW(nullptr), nullptr);
+
     ApplyFont(setOld_, g_body);
     ApplyFont(setNew_, g_body);
+    ApplyFont(auditOut_, g_body);
+    ApplyFont(breachStatus_, g_body);
+
+    breach_.Open(breach::IndexPath());
+    UpdateBreachStatus();
 }
 
 void MainWindow::ShowPage(HWND page) {
@@ -408,34 +455,13 @@ void MainWindow::ShowPage(HWND page) {
 }
 
 void MainWindow::UpdateVaultList() {
-    ListView_DeleteAllItems(listVault_);
-    int row = 0;
-    for (size_t i = 0; i < vault_.entries.size(); ++i) {
-        const auto& e = vault_.entries[i];
-        if (!filterCat_.empty() && filterCat_ != L"Все" && e.category != filterCat_) {
-            continue;
-        }
-        if (!filterText_.empty()) {
-            if (!ContainsI(e.title, filterText_) &&
-                !ContainsI(e.username, filterText_) &&
-                !ContainsI(e.url, filterText_) &&
-                !ContainsI(e.notes, filterText_) &&
-                !ContainsI(e.category, filterText_)) {
-                continue;
-            }
-        }
-        LVITEMW item{};
-        item.mask = LVIF_TEXT | LVIF_PARAM;
-        item.iItem = row;
-        item.lParam = (LPARAM)i;
-        item.pszText = (LPWSTR)e.title.c_str();
-        int inserted = ListView_InsertItem(listVault_, &item);
-        if (inserted >= 0) row = inserted;
-        ListView_SetItemText(listVault_, row, 1, (LPWSTR)e.category.c_str());
-        ListView_SetItemText(listVault_, row, 2, (LPWSTR)e.username.c_str());
-        ListView_SetItemText(listVault_, row, 3, (LPWSTR)e.url.c_str());
-        row++;
-    }
+    const bool allCats = filterCat_.empty() || filterCat_ == L"Все";
+    const uint32_t cat = allCats ? categories::Dictionary::kAny : categories_.Find(filterCat_);
+    view_.Refresh(vault_, index_, categories_, filterText_, cat, kMaxResults);
+    // Rows now mean different entries, so drop the selection before the
+    // list asks for them again.
+    ListView_SetItemState(listVault_, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+    ListView_SetItemCountEx(listVault_, (int)view_.Count(), 0);
 }
 
 void MainWindow::UpdateCategoryFilters() {
@@ -443,11 +469,7 @@ void MainWindow::UpdateCategoryFilters() {
     SendMessageW(filterCategory_, CB_ADDSTRING, 0, (LPARAM)L"Все");
 
     std::vector<std::wstring> cats;
-    for (const auto& e : vault_.entries) {
-        if (!e.category.empty()) cats.push_back(e.category);
-    }
-    std::sort(cats.begin(), cats.end());
-    cats.erase(std::unique(cats.begin(), cats.end()), cats.end());
+    categories_.Names(cats);
     for (const auto& c : cats) {
         SendMessageW(filterCategory_, CB_ADDSTRING, 0, (LPARAM)c.c_str());
     }
@@ -509,8 +531,13 @@ void MainWindow::LayoutHomePage(int w, int h) {
     y += 40;
     MoveWindow(lblNotes_, rightX, y, rightW, 20, TRUE);
     y += 20;
-    MoveWindow(editNotes_, rightX, y, rightW, 90, TRUE);
-    y += 110;
+    MoveWindow(editNotes_, rightX, y, rightW, 50, TRUE);
+    y += 60;
+    MoveWindow(listAttach_, rightX, y, rightW - 120, 200, TRUE);
+    MoveWindow(btnAttach_, rightX + rightW - 114, y - 2, 34, 30, TRUE);
+    MoveWindow(btnSaveAttach_, rightX + rightW - 74, y - 2, 34, 30, TRUE);
+    MoveWindow(btnDetach_, rightX + rightW - 34, y - 2, 34, 30, TRUE);
+    y += 40;
     MoveWindow(btnCopyUser_, rightX, y, (rightW / 2) - 5, 34, TRUE);
     MoveWindow(btnCopyPass_, rightX + (rightW / 2) + 5, y, (rightW / 2) - 5, 34, TRUE);
     y += 40;
@@ -525,15 +552,18 @@ void MainWindow::LayoutHomePage(int w, int h) {
 }
 
 void MainWindow::LoadSelection() {
-    int idx = GetSelectedEntryIndex(listVault_);
-    if (idx < 0 || idx >= (int)vault_.entries.size()) return;
-    const auto& e = vault_.entries[idx];
-    SetWindowTextW(editTitle_, e.title.c_str());
-    SetWindowTextW(editCategory_, e.category.c_str());
-    SetWindowTextW(editUser_, e.username.c_str());
-    SetWindowTextW(editPass_, e.password.c_str());
-    SetWindowTextW(editUrl_, e.url.c_str());
-    SetWindowTextW(editNotes_, e.notes.c_str());
+    int idx = GetSelectedEntryIndex(listVault_, view_);
+    if (idx < 0 || idx >= (int)vault_.entries.Size()) return;
+    const EntryRef e = vault_.entries[idx];
+    Secrets secrets;
+    vault::OpenSecrets(session_, e, secrets);
+    SetWindowTextW(editTitle_, e.title.data());
+    SetWindowTextW(editCategory_, e.category.data());
+    SetWindowTextW(editUser_, e.username.data());
+    SetWindowTextW(editPass_, secrets.password.c_str());
+    SetWindowTextW(editUrl_, e.url.data());
+    SetWindowTextW(editNotes_, secrets.notes.c_str());
+    UpdateAttachmentList(e.attachments);
 }
 
 void MainWindow::ClearEntryFields() {
@@ -543,36 +573,134 @@ void MainWindow::ClearEntryFields() {
     SetWindowTextW(editPass_, L"");
     SetWindowTextW(editUrl_, L"");
     SetWindowTextW(editNotes_, L"");
+    UpdateAttachmentList(AttachmentSpan());
+}
+
+void MainWindow::UpdateAttachmentList(const AttachmentSpan& list) {
+    SendMessageW(listAttach_, CB_RESETCONTENT, 0, 0);
+    for (const auto& a : list) {
+        SendMessageW(listAttach_, CB_ADDSTRING, 0, (LPARAM)a.name.c_str());
+    }
+    if (!list.empty()) SendMessageW(listAttach_, CB_SETCURSEL, 0, 0);
+}
+
+// Attachments are added to and removed from the selected saved entry
+// directly; only chunk references go into the journal.
+void MainWindow::AttachFile() {
+    int idx = GetSelectedEntryIndex(listVault_, view_);
+    if (idx < 0 || idx >= (int)vault_.entries.Size()) return;
+    wchar_t filePath[MAX_PATH] = L"";
+    OPENFILENAMEW ofn{};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd_;
+    ofn.lpstrFilter = L"All Files\0*.*\0";
+    ofn.lpstrFile = filePath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+    if (!GetOpenFileNameW(&ofn)) return;
+
+    Attachment a;
+    if (!attachments::Add(session_, filePath, a)) {
+        MessageBoxW(hwnd_, L"Не удалось добавить вложение.", L"LusaKey", MB_OK | MB_ICONERROR);
+        return;
+    }
+    Entry e;
+    vault_.entries.Load(idx, e);
+    e.attachments.push_back(std::move(a));
+    vault_.entries.Replace(idx, e);
+    if (!saves_.Put(e)) ShowSaveFailed(hwnd_);
+    UpdateAttachmentList(e.attachments);
+}
+
+void MainWindow::SaveAttachment() {
+    int idx = GetSelectedEntryIndex(listVault_, view_);
+    int sel = (int)SendMessageW(listAttach_, CB_GETCURSEL, 0, 0);
+    if (idx < 0 || idx >= (int)vault_.entries.Size()) return;
+    const EntryRef e = vault_.entries[idx];
+    if (sel < 0 || sel >= (int)e.attachments.size()) return;
+    const Attachment& a = e.attachments[sel];
+
+    wchar_t filePath[MAX_PATH] = L"";
+    wcsncpy_s(filePath, a.name.c_str(), _TRUNCATE);
+    OPENFILENAMEW ofn{};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd_;
+    ofn.lpstrFilter = L"All Files\0*.*\0";
+    ofn.lpstrFile = filePath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+    if (!GetSaveFileNameW(&ofn)) return;
+    if (!attachments::Export(session_, a, filePath)) {
+        MessageBoxW(hwnd_, L"Не удалось сохранить вложение.", L"LusaKey", MB_OK | MB_ICONERROR);
+    }
+}
+
+void MainWindow::DetachAttachment() {
+    int idx = GetSelectedEntryIndex(listVault_, view_);
+    int sel = (int)SendMessageW(listAttach_, CB_GETCURSEL, 0, 0);
+    if (idx < 0 || idx >= (int)vault_.entries.Size()) return;
+    Entry e;
+    vault_.entries.Load(idx, e);
+    if (sel < 0 || sel >= (int)e.attachments.size()) return;
+    e.attachments.erase(e.attachments.begin() + sel);
+    vault_.entries.Replace(idx, e);
+    if (!saves_.Put(e)) ShowSaveFailed(hwnd_);
+    UpdateAttachmentList(e.attachments);
 }
 
 void MainWindow::SaveEntry() {
     wchar_t buf[512];
     Entry e;
+    Secrets secrets;
     GetWindowTextW(editTitle_, buf, 512); e.title = buf;
     GetWindowTextW(editCategory_, buf, 512); e.category = buf;
     GetWindowTextW(editUser_, buf, 512); e.username = buf;
-    GetWindowTextW(editPass_, buf, 512); e.password = buf;
+    GetWindowTextW(editPass_, buf, 512); secrets.password = buf;
     GetWindowTextW(editUrl_, buf, 512); e.url = buf;
-    GetWindowTextW(editNotes_, buf, 512); e.notes = buf;
-
-    int idx = GetSelectedEntryIndex(listVault_);
-    if (idx >= 0 && idx < (int)vault_.entries.size()) {
-        vault_.entries[idx] = e;
+    GetWindowTextW(editNotes_, buf, 512); secrets.notes = buf;
+    crypto::SecureZero(buf, sizeof(buf));
+
+    int idx = GetSelectedEntryIndex(listVault_, view_);
+    bool existing = idx >= 0 && idx < (int)vault_.entries.Size();
+    e.id = existing ? vault_.entries.Id(idx) : vault_.nextId++;
+    if (existing) {
+        const AttachmentSpan kept = vault_.entries[idx].attachments;
+        e.attachments.assign(kept.begin(), kept.end());
+    }
+    // The change time moves only when the password itself does.
+    secrets.changed = (uint64_t)std::time(nullptr);
+    if (existing) {
+        Secrets previous;
+        if (vault::OpenSecrets(session_, vault_.entries[idx], previous) && previous.password == secrets.password) {
+            secrets.changed = previous.changed;
+        }
+    }
+    if (!vault::SealSecrets(session_, e, secrets)) return;
+    bool catsChanged;
+    if (existing) {
+        vault_.entries.Replace(idx, e);
+        index_.Update(idx, e);
+        catsChanged = categories_.Update(idx, e);
     } else {
-        vault_.entries.push_back(e);
+        vault_.entries.Append(e);
+        index_.Insert(e);
+        catsChanged = categories_.Insert(e);
     }
-    vault::Save(master_, vault_);
-    UpdateCategoryFilters();
+    if (!saves_.Put(e)) ShowSaveFailed(hwnd_);
+    if (catsChanged) UpdateCategoryFilters();
     UpdateVaultList();
     ClearEntryFields();
 }
 
 void MainWindow::DeleteEntry() {
-    int idx = GetSelectedEntryIndex(listVault_);
-    if (idx < 0 || idx >= (int)vault_.entries.size()) return;
-    vault_.entries.erase(vault_.entries.begin() + idx);
-    vault::Save(master_, vault_);
-    UpdateCategoryFilters();
+    int idx = GetSelectedEntryIndex(listVault_, view_);
+    if (idx < 0 || idx >= (int)vault_.entries.Size()) return;
+    uint64_t id = vault_.entries.Id(idx);
+    vault_.entries.Erase(idx);
+    index_.Erase(idx);
+    bool catsChanged = categories_.Erase(idx);
+    if (!saves_.Remove(id)) ShowSaveFailed(hwnd_);
+    if (catsChanged) UpdateCategoryFilters();
     UpdateVaultList();
     ClearEntryFields();
 }
@@ -585,8 +713,119 @@ void MainWindow::GeneratePassword() {
     bool upper = SendMessageW(genUpper_, BM_GETCHECK, 0, 0) == BST_CHECKED;
     bool digits = SendMessageW(genDigits_, BM_GETCHECK, 0, 0) == BST_CHECKED;
     bool symbols = SendMessageW(genSymbols_, BM_GETCHECK, 0, 0) == BST_CHECKED;
-    std::wstring out = passgen::Generate(len, lower, upper, digits, symbols);
+    // In phrase mode the length is a word count, Прописные capitalizes each
+    // word and Цифры appends two digits to one of them.
+    std::wstring out;
+    double bits = 0;
+    if (SendMessageW(genPhrase_, BM_GETCHECK, 0, 0) == BST_CHECKED) {
+        passgen::PhraseOptions options;
+        options.words = len;
+        GetWindowTextW(genSeparator_, buf, 32);
+        options.separator = buf;
+        options.capitalize = upper;
+        options.digits = digits ? 2 : 0;
+        out = passgen::Passphrase(options);
+        bits = passgen::Entropy(options);
+    } else {
+        passgen::Policy policy;
+        policy.length = len;
+        policy.use[passgen::kLower] = lower || !(upper || digits || symbols);
+        policy.use[passgen::kUpper] = upper;
+        policy.use[passgen::kDigits] = digits;
+        policy.use[passgen::kSymbols] = symbols;
+        if (SendMessageW(genEach_, BM_GETCHECK, 0, 0) == BST_CHECKED) {
+            for (int c = 0; c < passgen::kClasses; ++c) policy.minimum[c] = policy.use[c] ? 1 : 0;
+        }
+        policy.excludeSimilar = SendMessageW(genSimilar_, BM_GETCHECK, 0, 0) == BST_CHECKED;
+        out = passgen::Generate(policy);
+        bits = passgen::Entropy(policy);
+    }
     SetWindowTextW(genOut_, out.c_str());
+    bool breached = false;
+    breach_.Check(out, breached);
+    wchar_t entropy[96];
+    swprintf_s(entropy, L"Энтропия: %.1f бит%s", out.empty() ? 0.0 : bits, breached ? L", найден в утечках" : L"");
+    SetWindowTextW(genEntropy_, entropy);
+}
+
+// Shows the strength of the password being typed next to its label.
+void MainWindow::UpdatePasswordStrength() {
+    wchar_t buf[512];
+    int len = GetWindowTextW(editPass_, buf, 512);
+    if (len == 0) {
+        SetWindowTextW(lblPass_, L"Пароль");
+        return;
+    }
+    const strength::Estimate e = strength::Score(std::wstring_view(buf, len));
+    bool breached = false;
+    breach_.Check(std::wstring_view(buf, len), breached);
+    crypto::SecureZero(buf, sizeof(buf));
+    std::wstring label = L"Пароль — ";
+    label += strength::Label(e.score);
+    if (breached) label += L", найден в утечках";
+    SetWindowTextW(lblPass_, label.c_str());
+}
+
+// Lists entries by title only; the report itself holds no passwords.
+void MainWindow::RunAudit() {
+    audit::Report report;
+    if (!audit::Run(session_, vault_, (uint64_t)std::time(nullptr), audit::kDefaultMaxAge, report)) {
+        SetWindowTextW(auditOut_, L"Не удалось выполнить проверку.");
+        return;
+    }
+    std::wstring text = L"Повторяющиеся пароли: " + std::to_wstring(report.reused.size()) + L"\r\n";
+    for (const auto& group : report.reused) AppendTitles(vault_, group, text);
+    AppendSection(vault_, L"Пустые пароли", report.empty, text);
+    std::vector<strength::Estimate> scores;
+    strength::Score(session_, vault_, scores);
+    std::vector<size_t> weak;
+    // Empty and unreadable passwords score 0 bits and are listed above.
+    for (size_t pos = 0; pos < scores.size(); ++pos) {
+        if (scores[pos].score < 2 && scores[pos].bits > 0) weak.push_back(pos);
+    }
+    AppendSection(vault_, L"Слабые пароли", weak, text);
+    if (breach_.IsOpen()) {
+        std::vector<size_t> breached;
+        breach_.Check(session_, vault_, breached);
+        AppendSection(vault_, L"Найдены в утечках", breached, text);
+    }
+    AppendSection(vault_, L"Не менялись больше года", report.old, text);
+    if (!report.unreadable.empty()) AppendSection(vault_, L"Не удалось открыть", report.unreadable, text);
+    SetWindowTextW(auditOut_, text.c_str());
+}
+
+// The index is built off the UI thread; the checker stays closed until
+// WM_BREACH_BUILT, since the old index is replaced under it.
+void MainWindow::ChooseBreachCorpus() {
+    if (breachBuild_.joinable()) return;
+    wchar_t filePath[MAX_PATH] = L"";
+    OPENFILENAMEW ofn{};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd_;
+    ofn.lpstrFilter = L"Pwned Passwords (SHA-1)\0*.txt\0All Files\0*.*\0";
+    ofn.lpstrFile = filePath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+    if (!GetOpenFileNameW(&ofn)) return;
+
+    breach_.Close();
+    EnableWindow(breachBtn_, FALSE);
+    SetWindowTextW(breachStatus_, L"Построение индекса…");
+    HWND hwnd = hwnd_;
+    std::wstring corpus = filePath;
+    breachBuild_ = std::thread([this, hwnd, corpus]() {
+        bool ok = breach::Build(corpus, breach::IndexPath(), breachCancel_);
+        PostMessageW(hwnd, WM_BREACH_BUILT, ok, 0);
+    });
+}
+
+void MainWindow::UpdateBreachStatus() {
+    if (!breach_.IsOpen()) {
+        SetWindowTextW(breachStatus_, L"База не выбрана.");
+        return;
+    }
+    std::wstring text = L"Хешей в базе: " + std::to_wstring(breach_.Count());
+    SetWindowTextW(breachStatus_, text.c_str());
 }
 
 void MainWindow::CopyToClipboard(const std::wstring& text) {
@@ -663,7 +902,11 @@ void MainWindow::TickPageTransition() {
     SetWindowPos(animTo_, nullptr, xTo, 0, rc.right, rc.bottom, SWP_NOZORDER);
 }
 
+// The file is read into imported_ off the UI thread and merged on
+// WM_IMPORTED. Its ids are reserved up front, one per byte of the file,
+// so entries saved meanwhile cannot take them; the unused rest is skipped.
 void MainWindow::ImportCSV() {
+    if (importer_.joinable()) return;
     wchar_t filePath[MAX_PATH] = L"";
     OPENFILENAMEW ofn{};
     ofn.lStructSize = sizeof(ofn);
@@ -674,31 +917,60 @@ void MainWindow::ImportCSV() {
     ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
     if (!GetOpenFileNameW(&ofn)) return;
 
-    std::wifstream file(filePath);
-    file.imbue(std::locale(std::locale::classic(), new std::codecvt_utf8<wchar_t>));
-    if (!file) return;
+    WIN32_FILE_ATTRIBUTE_DATA info{};
+    if (!GetFileAttributesExW(filePath, GetFileExInfoStandard, &info)) {
+        MessageBoxW(hwnd_, L"Не удалось открыть файл.", L"LusaKey", MB_OK | MB_ICONERROR);
+        return;
+    }
+    const uint64_t size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+
+    EnableWindow(btnImport_, FALSE);
+    imported_.entries.Clear();
+    imported_.nextId = vault_.nextId;
+    vault_.nextId += size + 1;
+    importReport_ = csv::Report();
+    HWND hwnd = hwnd_;
+    std::wstring path = filePath;
+    importer_ = std::thread([this, hwnd, path]() {
+        importOk_ = csv::Import(session_, path, imported_, importReport_);
+        PostMessageW(hwnd, WM_IMPORTED, 0, 0);
+    });
+}
 
-    std::wstring line;
-    bool first = true;
-    while (std::getline(file, line)) {
-        if (first) {
-            first = false;
-            continue;
+void MainWindow::FinishImport() {
+    if (importer_.joinable()) importer_.join();
+    EnableWindow(btnImport_, TRUE);
+    const bool ok = importOk_;
+    const csv::Report& report = importReport_;
+    if (!imported_.entries.Empty()) {
+        for (const EntryRef& e : imported_.entries) vault_.entries.Append(e);
+        imported_.entries.Clear();
+        index_.Build(vault_);
+        categories_.Build(vault_);
+        if (!saves_.Compact(vault_)) ShowSaveFailed(hwnd_);
+        UpdateCategoryFilters();
+        UpdateVaultList();
+    }
+    if (ok && report.badCount == 0) return;
+
+    std::wstring text = L"Импортировано записей: " + std::to_wstring(report.imported) + L".";
+    if (!ok) text += L"\r\nФайл прочитан не полностью.";
+    if (report.badCount > 0) {
+        text += L"\r\nПропущено строк: " + std::to_wstring(report.badCount);
+        for (size_t i = 0; i < report.bad.size() && i < kMaxImportProblems; ++i) {
+            text += L"\r\n  строка " + std::to_wstring(report.bad[i].line) + L" — " + csv::Describe(report.bad[i].problem);
         }
-        auto cols = CsvSplit(line);
-        if (cols.size() < 5) continue;
-        Entry e;
-        e.title = cols.size() > 0 ? cols[0] : L"";
-        e.category = cols.size() > 1 ? cols[1] : L"";
-        e.username = cols.size() > 2 ? cols[2] : L"";
-        e.password = cols.size() > 3 ? cols[3] : L"";
-        e.url = cols.size() > 4 ? cols[4] : L"";
-        e.notes = cols.size() > 5 ? cols[5] : L"";
-        vault_.entries.push_back(e);
-    }
-    vault::Save(master_, vault_);
-    UpdateCategoryFilters();
-    UpdateVaultList();
+        if (report.badCount > kMaxImportProblems) {
+            text += L"\r\n  и ещё " + std::to_wstring(report.badCount - kMaxImportProblems);
+        }
+    }
+    MessageBoxW(hwnd_, text.c_str(), L"LusaKey", MB_OK | (ok ? MB_ICONWARNING : MB_ICONERROR));
+}
+
+// After a failed write, one full checkpoint is tried before giving up.
+bool MainWindow::FlushSaves() {
+    if (saves_.Flush()) return true;
+    return saves_.Compact(vault_) && saves_.Flush();
 }
 
 void MainWindow::ExportCSV() {
@@ -719,12 +991,14 @@ void MainWindow::ExportCSV() {
 
     file << L"title,category,username,password,url,notes\n";
     for (const auto& e : vault_.entries) {
+        Secrets secrets;
+        vault::OpenSecrets(session_, e, secrets);
         file << CsvEscape(e.title) << L","
             << CsvEscape(e.category) << L","
             << CsvEscape(e.username) << L","
-            << CsvEscape(e.password) << L","
+            << CsvEscape(secrets.password) << L","
             << CsvEscape(e.url) << L","
-            << CsvEscape(e.notes) << L"\n";
+            << CsvEscape(secrets.notes) << L"\n";
     }
 }
 
@@ -758,6 +1032,13 @@ LRESULT CALLBACK MainWindow::PageProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
         DeleteObject(br);
         return 1;
     }
+    case WM_COMMAND:
+    case WM_NOTIFY: {
+        // Child controls report to their page; the main window handles them.
+        HWND root = GetAncestor(hwnd, GA_ROOT);
+        if (root && root != hwnd) return SendMessageW(root, msg, wParam, lParam);
+        break;
+    }
     }
     return DefWindowProcW(hwnd, msg, wParam, lParam);
 }
@@ -800,14 +1081,27 @@ LRESULT CALLBACK MainWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
         if (id == ID_LOGIN) {
             wchar_t buf[128];
             GetWindowTextW(self->editMaster_, buf, 128);
-            self->master_ = buf;
+            std::wstring master = buf;
+            crypto::SecureZero(buf, sizeof(buf));
             Vault v;
-            if (vault::Load(self->master_, v)) {
+            self->saves_.Stop();
+            self->vaultOpened_ = self->store_.Open(self->session_, master, v);
+            if (self->vaultOpened_) {
                 self->vault_ = v;
+                if (self->store_.RewriteFailed()) {
+                    MessageBoxW(hwnd, L"Не удалось обновить файл хранилища. Попытка повторится при следующем входе.",
+                        L"LusaKey", MB_OK | MB_ICONWARNING);
+                }
             } else {
-                self->vault_.entries.clear();
-                vault::Save(self->master_, self->vault_);
+                self->vault_ = Vault();
+                if (self->session_.Create(master)) {
+                    self->store_.Create(self->session_, self->vault_);
+                }
             }
+            crypto::SecureZero(&master[0], master.size() * sizeof(wchar_t));
+            self->saves_.Start(self->session_, self->store_, self->vault_, hwnd, WM_SAVED, self->vaultOpened_);
+            self->index_.Build(self->vault_);
+            self->categories_.Build(self->vault_);
             self->filterText_.clear();
             SetWindowTextW(self->searchBox_, L"");
             self->UpdateCategoryFilters();
@@ -860,6 +1154,12 @@ LRESULT CALLBACK MainWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
             self->OpenUrlFromField();
         } else if (id == ID_AUTOFILL) {
             self->AutofillPlaceholder();
+        } else if (id == ID_ATTACH) {
+            self->AttachFile();
+        } else if (id == ID_SAVE_ATTACH) {
+            self->SaveAttachment();
+        } else if (id == ID_DETACH) {
+            self->DetachAttachment();
         } else if (id == ID_IMPORT) {
             self->ImportCSV();
         } else if (id == ID_EXPORT) {
@@ -871,19 +1171,49 @@ LRESULT CALLBACK MainWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
             GetWindowTextW(self->genOut_, buf, 256);
             self->CopyToClipboard(buf);
         } else if (id == ID_SET) {
+            // The vault is re-read from disk and rewritten under the new
+            // key, so queued edits have to be written first.
+            if (!self->FlushSaves()) {
+                ShowSaveFailed(hwnd);
+                return 0;
+            }
             wchar_t oldp[128], newp[128];
             GetWindowTextW(self->setOld_, oldp, 128);
             GetWindowTextW(self->setNew_, newp, 128);
+            std::wstring oldPassword = oldp;
+            std::wstring newPassword = newp;
+            crypto::SecureZero(oldp, sizeof(oldp));
+            crypto::SecureZero(newp, sizeof(newp));
             Vault v;
-            if (vault::Load(oldp, v)) {
-                self->master_ = newp;
+            crypto::Session check;
+            crypto::Session staged;
+            self->saves_.Stop();
+            self->store_.Flush();
+            // The new key replaces the session's only once the checkpoint
+            // under it is on disk.
+            const bool opened = self->store_.Open(check, oldPassword, v);
+            if (opened && check.Rekey(newPassword, staged) && self->store_.Create(staged, v)) {
+                self->session_.Swap(staged);
                 self->vault_ = v;
-                vault::Save(self->master_, self->vault_);
+                self->index_.Build(self->vault_);
+                self->categories_.Build(self->vault_);
                 self->UpdateCategoryFilters();
                 self->UpdateVaultList();
                 SetWindowTextW(self->setOld_, L"");
                 SetWindowTextW(self->setNew_, L"");
+            } else {
+                MessageBoxW(hwnd, opened ? L"Не удалось сменить мастер-пароль." : L"Неверный текущий пароль.",
+                    L"LusaKey", MB_OK | MB_ICONERROR);
             }
+            crypto::SecureZero(&oldPassword[0], oldPassword.size() * sizeof(wchar_t));
+            crypto::SecureZero(&newPassword[0], newPassword.size() * sizeof(wchar_t));
+            self->saves_.Start(self->session_, self->store_, self->vault_, hwnd, WM_SAVED, self->vaultOpened_);
+        } else if (id == ID_AUDIT) {
+            self->RunAudit();
+        } else if (id == ID_BREACH) {
+            self->ChooseBreachCorpus();
+        } else if (id == ID_PASS && HIWORD(wParam) == EN_CHANGE) {
+            self->UpdatePasswordStrength();
         } else if (id == ID_SEARCH && HIWORD(wParam) == EN_CHANGE) {
             wchar_t buf[256];
             GetWindowTextW(self->searchBox_, buf, 256);
@@ -903,7 +1233,14 @@ LRESULT CALLBACK MainWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
     case WM_NOTIFY: {
         LPNMHDR hdr = (LPNMHDR)lParam;
         if (hdr->idFrom == ID_VAULT_LIST) {
-            if (hdr->code == LVN_ITEMCHANGED) {
+            if (hdr->code == LVN_GETDISPINFOW) {
+                LVITEMW& item = ((NMLVDISPINFOW*)lParam)->item;
+                if ((item.mask & LVIF_TEXT) && item.pszText && item.cchTextMax > 0) {
+                    std::wstring_view text = self->view_.Cell(self->vault_, (size_t)item.iItem, item.iSubItem);
+                    wcsncpy_s(item.pszText, item.cchTextMax, text.data(), _TRUNCATE);
+                }
+                return 0;
+            } else if (hdr->code == LVN_ITEMCHANGED) {
                 self->LoadSelection();
             } else if (hdr->code == NM_CUSTOMDRAW) {
                 LPNMLVCUSTOMDRAW cd = (LPNMLVCUSTOMDRAW)lParam;
@@ -969,7 +1306,29 @@ LRESULT CALLBACK MainWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
         EndPaint(hwnd, &ps);
         return 0;
     }
+    case WM_SAVED:
+        if (!wParam) ShowSaveFailed(hwnd);
+        return 0;
+    case WM_BREACH_BUILT:
+        if (self->breachBuild_.joinable()) self->breachBuild_.join();
+        EnableWindow(self->breachBtn_, TRUE);
+        // A failed build leaves the previous index in place.
+        self->breach_.Open(breach::IndexPath());
+        if (wParam) {
+            self->UpdateBreachStatus();
+        } else {
+            SetWindowTextW(self->breachStatus_, L"Не удалось построить индекс: нужен отсортированный список SHA-1.");
+        }
+        return 0;
+    case WM_IMPORTED:
+        self->FinishImport();
+        return 0;
     case WM_DESTROY:
+        self->breachCancel_ = true;
+        if (self->breachBuild_.joinable()) self->breachBuild_.join();
+        if (self->importer_.joinable()) self->importer_.join();
+        if (!self->FlushSaves()) ShowSaveFailed(nullptr);
+        self->saves_.Stop();
         PostQuitMessage(0);
         return 0;
     }
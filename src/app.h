@@ -1,7 +1,14 @@
 #pragma once
 
 #include <windows.h>
+#include <atomic>
 #include <string>
+#include <thread>
+#include "breach.h"
+#include "csv_import.h"
+#include "save_queue.h"
+#include "search.h"
+#include "vault_view.h"
 #include "vault.h"
 
 class MainWindow {
@@ -44,6 +51,10 @@ private:
     HWND btnCopyPass_ = nullptr;
     HWND btnOpenUrl_ = nullptr;
     HWND btnAutofill_ = nullptr;
+    HWND listAttach_ = nullptr;
+    HWND btnAttach_ = nullptr;
+    HWND btnSaveAttach_ = nullptr;
+    HWND btnDetach_ = nullptr;
 
     HWND searchBox_ = nullptr;
     HWND filterCategory_ = nullptr;
@@ -55,18 +66,43 @@ private:
     HWND genUpper_ = nullptr;
     HWND genDigits_ = nullptr;
     HWND genSymbols_ = nullptr;
+    HWND genSeparator_ = nullptr;
+    HWND genPhrase_ = nullptr;
+    HWND genSimilar_ = nullptr;
+    HWND genEach_ = nullptr;
     HWND genOut_ = nullptr;
+    HWND genEntropy_ = nullptr;
     HWND genBtn_ = nullptr;
     HWND genCopy_ = nullptr;
 
     HWND setOld_ = nullptr;
     HWND setNew_ = nullptr;
     HWND setBtn_ = nullptr;
+    HWND auditBtn_ = nullptr;
+    HWND auditOut_ = nullptr;
+    HWND breachBtn_ = nullptr;
+    HWND breachStatus_ = nullptr;
 
-    std::wstring master_;
+    crypto::Session session_;
+    vault::Store store_;
+    vault::SaveQueue saves_;
+    // False while the vault is one created because unlock failed; its
+    // saves must not sweep the previous vault's attachment objects.
+    bool vaultOpened_ = false;
     Vault vault_;
+    search::Index index_;
+    categories::Dictionary categories_;
+    view::VaultView view_;
     std::wstring filterText_;
     std::wstring filterCat_;
+    breach::Checker breach_;
+    std::thread breachBuild_;
+    std::atomic<bool> breachCancel_{ false };
+    // Filled by importer_ and merged into vault_ on WM_IMPORTED.
+    std::thread importer_;
+    Vault imported_;
+    csv::Report importReport_;
+    bool importOk_ = false;
 
     int navIndicatorY_ = 140;
     int navTargetY_ = 140;
@@ -92,13 +128,23 @@ private:
     void SaveEntry();
     void DeleteEntry();
     void GeneratePassword();
+    void UpdatePasswordStrength();
+    void RunAudit();
+    void ChooseBreachCorpus();
+    void UpdateBreachStatus();
     void CopyToClipboard(const std::wstring& text);
     void StartPageTransition(HWND page, int dir);
     void TickPageTransition();
     void ImportCSV();
+    void FinishImport();
+    bool FlushSaves();
     void ExportCSV();
     void OpenUrlFromField();
     void AutofillPlaceholder();
+    void AttachFile();
+    void SaveAttachment();
+    void DetachAttachment();
+    void UpdateAttachmentList(const AttachmentSpan& list);
     void AnimateNav();
 
     static LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
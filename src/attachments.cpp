@@ -0,0 +1,250 @@
+#include "attachments.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+
+namespace {
+    const size_t kMinChunk = 256 * 1024;
+    const size_t kMaxChunk = 4 * 1024 * 1024;
+    // Cut where the top 20 bits of the rolling hash are zero: chunks average
+    // about kMinChunk + 1 MiB.
+    const uint64_t kCutMask = 0xFFFFF00000000000ull;
+    const size_t kHmacKeyLen = 32;
+    const size_t kOverhead = crypto::Key::kNonceSize + crypto::Key::kTagSize;
+    const char kSubkeyLabel[] = "LSK attach";
+
+    // Objects Add has written or reused in this process. Their references
+    // may not have reached the vault a sweep is given yet, so a sweep never
+    // deletes them.
+    std::mutex g_pendingLock;
+    std::unordered_set<std::wstring> g_pending;
+
+    struct Keys {
+        unsigned char hmac[kHmacKeyLen];
+        uint64_t gear[256];
+
+        ~Keys() { crypto::SecureZero(this, sizeof(*this)); }
+    };
+
+    uint64_t SplitMix(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // The gear table is seeded from the records key as well, so chunk
+    // boundaries (visible as object sizes) do not follow a public function
+    // of the contents.
+    bool DeriveKeys(const crypto::Session& session, Keys& keys) {
+        unsigned char material[kHmacKeyLen + 8];
+        if (!session.Subkey(kSubkeyLabel, material, sizeof(material))) return false;
+        memcpy(keys.hmac, material, kHmacKeyLen);
+        uint64_t state = 0;
+        for (int i = 0; i < 8; ++i) state |= (uint64_t)material[kHmacKeyLen + i] << (8 * i);
+        for (auto& g : keys.gear) g = SplitMix(state);
+        crypto::SecureZero(material, sizeof(material));
+        crypto::SecureZero(&state, sizeof(state));
+        return true;
+    }
+
+    // Gear rolling hash: a boundary depends only on the bytes just before it,
+    // so an edit early in a file leaves the later chunks, and their objects,
+    // unchanged.
+    size_t Cut(const Keys& keys, const unsigned char* p, size_t n) {
+        if (n <= kMinChunk) return n;
+        const size_t limit = std::min(n, kMaxChunk);
+        uint64_t h = 0;
+        for (size_t i = kMinChunk; i < limit; ++i) {
+            h = (h << 1) + keys.gear[p[i]];
+            if ((h & kCutMask) == 0) return i + 1;
+        }
+        return limit;
+    }
+
+    std::wstring ObjectPath(const unsigned char* id) {
+        static const wchar_t digits[] = L"0123456789abcdef";
+        std::wstring name(2 * sizeof(ChunkRef::id), L'0');
+        for (size_t i = 0; i < sizeof(ChunkRef::id); ++i) {
+            name[2 * i] = digits[id[i] >> 4];
+            name[2 * i + 1] = digits[id[i] & 0xF];
+        }
+        return attachments::ObjectsPath() + L"\\" + name;
+    }
+
+    std::wstring FileName(const std::wstring& path) {
+        size_t slash = path.find_last_of(L"\\/");
+        return slash == std::wstring::npos ? path : path.substr(slash + 1);
+    }
+
+    bool ReadAll(HANDLE h, unsigned char* out, size_t len) {
+        while (len > 0) {
+            DWORD read = 0;
+            if (!ReadFile(h, out, (DWORD)len, &read, nullptr) || read == 0) return false;
+            out += read;
+            len -= read;
+        }
+        return true;
+    }
+
+    bool WriteAll(HANDLE h, const unsigned char* data, size_t len) {
+        while (len > 0) {
+            DWORD written = 0;
+            if (!WriteFile(h, data, (DWORD)len, &written, nullptr) || written == 0) return false;
+            data += written;
+            len -= written;
+        }
+        return true;
+    }
+
+    // Objects are immutable: one already on disk under this name holds the
+    // same chunk, so only new chunks cost a write.
+    bool PutObject(const crypto::Session& session, const Keys& keys, const unsigned char* data, size_t len,
+        ChunkRef& ref, std::vector<unsigned char>& sealed) {
+        ref.size = (uint32_t)len;
+        if (!crypto::Engine::Get().HmacSha256(keys.hmac, kHmacKeyLen, data, len, ref.id)) return false;
+        const std::wstring path = ObjectPath(ref.id);
+        {
+            std::lock_guard<std::mutex> guard(g_pendingLock);
+            g_pending.insert(path);
+        }
+        if (GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES) return true;
+
+        sealed.resize(kOverhead + len);
+        unsigned char* nonce = sealed.data();
+        unsigned char* tag = nonce + crypto::Key::kNonceSize;
+        if (!crypto::Engine::Get().Random(nonce, crypto::Key::kNonceSize)) return false;
+        if (!session.RecordKey().Encrypt(nonce, ref.id, sizeof(ref.id), data, len, tag + crypto::Key::kTagSize, tag)) {
+            return false;
+        }
+        const std::wstring tmp = path + L".tmp";
+        HANDLE h = CreateFileW(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        bool ok = WriteAll(h, sealed.data(), sealed.size()) && FlushFileBuffers(h);
+        CloseHandle(h);
+        ok = ok && MoveFileExW(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+        if (!ok) DeleteFileW(tmp.c_str());
+        return ok;
+    }
+
+    bool OpenObject(const crypto::Session& session, const ChunkRef& ref,
+        std::vector<unsigned char>& sealed, std::vector<unsigned char>& plain) {
+        HANDLE h = CreateFileW(ObjectPath(ref.id).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size{};
+        bool ok = GetFileSizeEx(h, &size) && size.QuadPart == (LONGLONG)(kOverhead + ref.size);
+        if (ok) {
+            sealed.resize(kOverhead + ref.size);
+            ok = ReadAll(h, sealed.data(), sealed.size());
+        }
+        CloseHandle(h);
+        if (!ok) return false;
+        const unsigned char* nonce = sealed.data();
+        const unsigned char* tag = nonce + crypto::Key::kNonceSize;
+        plain.resize(ref.size);
+        return session.RecordKey().Decrypt(nonce, ref.id, sizeof(ref.id), tag + crypto::Key::kTagSize,
+            ref.size, plain.data(), tag);
+    }
+}
+
+namespace attachments {
+    std::wstring ObjectsPath() {
+        std::wstring path = vault::VaultPath();
+        return path.substr(0, path.find_last_of(L'\\')) + L"\\objects";
+    }
+
+    bool Add(const crypto::Session& session, const std::wstring& path, Attachment& out) {
+        Keys keys;
+        if (!DeriveKeys(session, keys)) return false;
+        HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        CreateDirectoryW(ObjectsPath().c_str(), nullptr);
+
+        Attachment a;
+        a.name = FileName(path);
+        std::vector<unsigned char> buf(kMaxChunk);
+        std::vector<unsigned char> sealed;
+        size_t have = 0;
+        bool eof = false;
+        bool ok = true;
+        while (ok) {
+            while (!eof && have < buf.size()) {
+                DWORD read = 0;
+                if (!ReadFile(h, buf.data() + have, (DWORD)(buf.size() - have), &read, nullptr)) {
+                    ok = false;
+                    break;
+                }
+                if (read == 0) eof = true;
+                have += read;
+            }
+            if (!ok || have == 0) break;
+            ChunkRef ref;
+            size_t cut = Cut(keys, buf.data(), have);
+            ok = PutObject(session, keys, buf.data(), cut, ref, sealed);
+            a.chunks.push_back(ref);
+            a.size += cut;
+            memmove(buf.data(), buf.data() + cut, have - cut);
+            have -= cut;
+        }
+        CloseHandle(h);
+        crypto::SecureZero(buf.data(), buf.size());
+        if (ok) out = std::move(a);
+        return ok;
+    }
+
+    bool Export(const crypto::Session& session, const Attachment& a, const std::wstring& path) {
+        HANDLE h = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        std::vector<unsigned char> sealed;
+        std::vector<unsigned char> plain;
+        uint64_t total = 0;
+        bool ok = true;
+        for (size_t i = 0; ok && i < a.chunks.size(); ++i) {
+            ok = OpenObject(session, a.chunks[i], sealed, plain) && WriteAll(h, plain.data(), plain.size());
+            total += plain.size();
+            crypto::SecureZero(plain.data(), plain.size());
+        }
+        ok = ok && total == a.size;
+        CloseHandle(h);
+        if (!ok) DeleteFileW(path.c_str());
+        return ok;
+    }
+
+    void Sweep(const Vault& v) {
+        std::unordered_set<std::wstring> live;
+        for (const auto& e : v.entries) {
+            for (const auto& a : e.attachments) {
+                for (const auto& c : a.chunks) live.insert(ObjectPath(c.id));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(g_pendingLock);
+            for (const auto& path : live) g_pending.erase(path);
+        }
+        const std::wstring dir = ObjectsPath();
+        const std::wstring tmp = L".tmp";
+        WIN32_FIND_DATAW fd;
+        HANDLE find = FindFirstFileW((dir + L"\\*").c_str(), &fd);
+        if (find == INVALID_HANDLE_VALUE) return;
+        do {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            const std::wstring path = dir + L"\\" + fd.cFileName;
+            std::wstring object = path;
+            if (object.size() > tmp.size() && object.compare(object.size() - tmp.size(), tmp.size(), tmp) == 0) {
+                object.resize(object.size() - tmp.size());
+            }
+            if (live.find(object) != live.end()) continue;
+            // Checked and deleted under the lock, so an Add that finds the
+            // object afterwards has already marked it, and one that runs
+            // first sees it gone and writes it again.
+            std::lock_guard<std::mutex> guard(g_pendingLock);
+            if (g_pending.find(object) == g_pending.end()) DeleteFileW(path.c_str());
+        } while (FindNextFileW(find, &fd));
+        FindClose(find);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+#include "crypto.h"
+#include "vault.h"
+
+// Attachments are cut into content-defined chunks and stored one object per
+// chunk under objects\ next to vault.dat. Objects are named by an HMAC of
+// the chunk keyed from the records key, so identical chunks are stored once
+// across all entries, and sealed under the records key with their name as
+// associated data. Nothing is read until an attachment is exported.
+namespace attachments {
+    std::wstring ObjectsPath();
+
+    // Reads the file a chunk at a time and writes only chunks not already
+    // stored; out receives the references.
+    bool Add(const crypto::Session& session, const std::wstring& path, Attachment& out);
+    bool Export(const crypto::Session& session, const Attachment& a, const std::wstring& path);
+
+    // Deletes objects no entry in v refers to, except those Add has handed
+    // out in this process. Lists the whole objects directory, so it belongs
+    // on a worker thread, and v must be what the store has committed.
+    void Sweep(const Vault& v);
+}
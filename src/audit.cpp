@@ -0,0 +1,100 @@
+#include "audit.h"
+#include "parallel.h"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+    const uint32_t kNoGroup = 0xFFFFFFFF;
+
+    enum : uint8_t {
+        kHashed = 1,
+        kEmpty = 2,
+        kOld = 4,
+        kUnreadable = 8
+    };
+
+    struct Digest {
+        unsigned char bytes[32];
+    };
+
+    // Keyed digests are uniform already, so their first bytes are the hash.
+    struct DigestHash {
+        size_t operator()(const Digest* d) const {
+            size_t h;
+            memcpy(&h, d->bytes, sizeof(h));
+            return h;
+        }
+    };
+
+    struct DigestEqual {
+        bool operator()(const Digest* a, const Digest* b) const {
+            return memcmp(a->bytes, b->bytes, sizeof(a->bytes)) == 0;
+        }
+    };
+}
+
+namespace audit {
+    bool Run(const crypto::Session& session, const Vault& v, uint64_t now, uint64_t maxAge, Report& out) {
+        out = Report();
+        const crypto::Engine& engine = crypto::Engine::Get();
+        unsigned char key[32];
+        if (!engine.Random(key, sizeof(key))) return false;
+
+        const size_t n = v.entries.Size();
+        std::vector<Digest> digests(n);
+        std::vector<uint8_t> flags(n, 0);
+        parallel::ForBlocks(n, parallel::kMinSecretsPerThread, [&](size_t begin, size_t end) {
+            for (size_t pos = begin; pos < end; ++pos) {
+                Secrets secrets;
+                if (!vault::OpenSecrets(session, v.entries[pos], secrets)) {
+                    flags[pos] = kUnreadable;
+                    continue;
+                }
+                const std::wstring& password = secrets.password;
+                if (password.empty()) {
+                    flags[pos] = kEmpty;
+                    continue;
+                }
+                uint8_t f = 0;
+                if (engine.HmacSha256(key, sizeof(key), (const unsigned char*)password.data(),
+                        password.size() * sizeof(wchar_t), digests[pos].bytes)) {
+                    f |= kHashed;
+                }
+                if (secrets.changed != 0 && now > secrets.changed && now - secrets.changed > maxAge) f |= kOld;
+                flags[pos] = f;
+            }
+        });
+        crypto::SecureZero(key, sizeof(key));
+
+        std::unordered_map<const Digest*, uint32_t, DigestHash, DigestEqual> groups;
+        groups.reserve(n);
+        std::vector<uint32_t> groupOf(n, kNoGroup);
+        std::vector<uint32_t> sizes;
+        for (size_t pos = 0; pos < n; ++pos) {
+            if (!(flags[pos] & kHashed)) continue;
+            auto it = groups.emplace(&digests[pos], (uint32_t)sizes.size());
+            if (it.second) sizes.push_back(0);
+            groupOf[pos] = it.first->second;
+            ++sizes[groupOf[pos]];
+        }
+
+        std::vector<uint32_t> slots(sizes.size(), kNoGroup);
+        for (size_t pos = 0; pos < n; ++pos) {
+            const uint32_t g = groupOf[pos];
+            if (g != kNoGroup && sizes[g] > 1) {
+                if (slots[g] == kNoGroup) {
+                    slots[g] = (uint32_t)out.reused.size();
+                    out.reused.emplace_back();
+                }
+                out.reused[slots[g]].push_back(pos);
+            }
+            if (flags[pos] & kEmpty) out.empty.push_back(pos);
+            if (flags[pos] & kOld) out.old.push_back(pos);
+            if (flags[pos] & kUnreadable) out.unreadable.push_back(pos);
+        }
+        groups.clear();
+        crypto::SecureZero(digests.data(), digests.size() * sizeof(Digest));
+        return true;
+    }
+}
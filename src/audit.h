@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "crypto.h"
+#include "vault.h"
+
+namespace audit {
+    const uint64_t kDefaultMaxAge = 365ull * 24 * 60 * 60;
+
+    // Vault positions only, valid until the vault changes; nothing derived
+    // from a password is kept.
+    struct Report {
+        // Entries sharing one password, each group in vault order and the
+        // groups ordered by their first entry.
+        std::vector<std::vector<size_t>> reused;
+        std::vector<size_t> empty;
+        // Passwords last changed more than maxAge seconds before now.
+        // Entries with no recorded change time are never old.
+        std::vector<size_t> old;
+        // Entries whose secrets failed to open.
+        std::vector<size_t> unreadable;
+    };
+
+    // Opens every entry's secrets across threads and compares passwords by
+    // HMAC-SHA256 under a random key made for this run and wiped after, so
+    // the digests mean nothing outside it. False only if no key could be
+    // made.
+    bool Run(const crypto::Session& session, const Vault& v, uint64_t now, uint64_t maxAge, Report& out);
+}
@@ -0,0 +1,386 @@
+#include "breach.h"
+#include "codec.h"
+#include "parallel.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const unsigned char kMagic[4] = { 'L', 'S', 'K', 'H' };
+    const uint32_t kVersion = 1;
+    const size_t kHexLen = 2 * breach::kHashSize;
+    // The shortest line, "HASH:1\n", is 43 bytes, so sizing by this slightly
+    // overestimates the count rather than overfilling the filter.
+    const uint64_t kBytesPerLine = 44;
+    const uint64_t kLinesPerBucket = 256;
+    const uint32_t kMinBucketBits = 8;
+    const uint32_t kMaxBucketBits = 24;
+    // One cache line per block; 10 bits per key and 7 probes let about one
+    // lookup in a hundred through to the corpus.
+    const size_t kBlockBytes = 64;
+    const uint64_t kBitsPerKey = 10;
+    const int kProbes = 7;
+    const size_t kReadChunk = 1 << 20;
+    const size_t kMaxLine = 64;
+
+    struct Header {
+        uint64_t corpusSize = 0;
+        uint64_t corpusTime = 0;
+        uint64_t count = 0;
+        uint32_t bucketBits = 0;
+        uint64_t blocks = 0;
+    };
+
+    void WriteHeader(const Header& h, const std::wstring& corpusPath, std::vector<unsigned char>& out) {
+        codec::Writer w(out);
+        w.Raw(kMagic, sizeof(kMagic));
+        w.U32(kVersion);
+        w.U64(h.corpusSize);
+        w.U64(h.corpusTime);
+        w.U64(h.count);
+        w.U32(h.bucketBits);
+        w.U64(h.blocks);
+        w.Text(corpusPath);
+    }
+
+    size_t RoundUp(size_t n, size_t to) {
+        return (n + to - 1) / to * to;
+    }
+
+    uint64_t IndexSize(size_t headerLen, const Header& h) {
+        return headerLen + h.blocks * kBlockBytes + ((1ull << h.bucketBits) + 1) * sizeof(uint64_t);
+    }
+
+    // Size and last write time; an index only matches the corpus it was
+    // built from.
+    bool Stamp(HANDLE file, uint64_t& size, uint64_t& time) {
+        LARGE_INTEGER s{};
+        FILETIME t{};
+        if (!GetFileSizeEx(file, &s) || !GetFileTime(file, nullptr, nullptr, &t)) return false;
+        size = (uint64_t)s.QuadPart;
+        time = ((uint64_t)t.dwHighDateTime << 32) | t.dwLowDateTime;
+        return true;
+    }
+
+    int HexValue(unsigned char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        c |= 0x20;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    bool ParseHash(const unsigned char* p, unsigned char* hash) {
+        for (size_t i = 0; i < breach::kHashSize; ++i) {
+            int hi = HexValue(p[2 * i]);
+            int lo = HexValue(p[2 * i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            hash[i] = (unsigned char)(hi << 4 | lo);
+        }
+        return true;
+    }
+
+    // "HASH:COUNT" in either case, with or without the CR.
+    bool ParseLine(const unsigned char* p, size_t len, unsigned char* hash) {
+        if (len > 0 && p[len - 1] == '\r') --len;
+        if (len < kHexLen + 2 || p[kHexLen] != ':' || !ParseHash(p, hash)) return false;
+        for (size_t i = kHexLen + 1; i < len; ++i) {
+            if (p[i] < '0' || p[i] > '9') return false;
+        }
+        return true;
+    }
+
+    uint32_t Bucket(const unsigned char* hash, uint32_t bits) {
+        uint32_t prefix = (uint32_t)hash[0] << 24 | (uint32_t)hash[1] << 16 | (uint32_t)hash[2] << 8 | hash[3];
+        return prefix >> (32 - bits);
+    }
+
+    // The bucket takes the leading bytes of the hash and the filter the
+    // ones after, which for SHA-1 are independent of them.
+    size_t BlockOf(const unsigned char* hash, uint64_t blocks) {
+        uint32_t x;
+        memcpy(&x, hash + 4, sizeof(x));
+        return (size_t)(((uint64_t)x * blocks) >> 32) * kBlockBytes;
+    }
+
+    uint64_t Probes(const unsigned char* hash) {
+        uint64_t p;
+        memcpy(&p, hash + 8, sizeof(p));
+        return p;
+    }
+
+    void Insert(unsigned char* block, const unsigned char* hash) {
+        uint64_t p = Probes(hash);
+        for (int i = 0; i < kProbes; ++i, p >>= 9) block[(p & 511) >> 3] |= (unsigned char)(1u << (p & 7));
+    }
+
+    bool MayContain(const unsigned char* block, const unsigned char* hash) {
+        uint64_t p = Probes(hash);
+        for (int i = 0; i < kProbes; ++i, p >>= 9) {
+            if (!(block[(p & 511) >> 3] & (1u << (p & 7)))) return false;
+        }
+        return true;
+    }
+
+    // The index being built: a temporary file mapped read-write at its final
+    // size, so a filter of hundreds of megabytes is filled in place rather
+    // than on the heap. Renamed over the target only once complete.
+    class OutputMap {
+    public:
+        OutputMap() = default;
+        ~OutputMap() { Discard(); }
+        OutputMap(const OutputMap&) = delete;
+        OutputMap& operator=(const OutputMap&) = delete;
+
+        bool Create(const std::wstring& path, uint64_t size) {
+            path_ = path;
+            file_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE || size > SIZE_MAX) return false;
+            // Extending the file zero-fills it, which is the empty filter.
+            LARGE_INTEGER end{};
+            end.QuadPart = (LONGLONG)size;
+            if (!SetFilePointerEx(file_, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)) return false;
+            HANDLE mapping = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+            if (!mapping) return false;
+            view_ = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+            CloseHandle(mapping);
+            return view_ != nullptr;
+        }
+
+        unsigned char* Data() { return (unsigned char*)view_; }
+
+        bool Commit(const std::wstring& target) {
+            bool ok = FlushViewOfFile(view_, 0) != 0;
+            UnmapViewOfFile(view_);
+            view_ = nullptr;
+            ok = FlushFileBuffers(file_) && ok;
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+            ok = ok && MoveFileExW(path_.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+            if (!ok) DeleteFileW(path_.c_str());
+            return ok;
+        }
+
+        void Discard() {
+            if (view_) UnmapViewOfFile(view_);
+            view_ = nullptr;
+            if (file_ == INVALID_HANDLE_VALUE) return;
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+            DeleteFileW(path_.c_str());
+        }
+
+    private:
+        std::wstring path_;
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+        void* view_ = nullptr;
+    };
+}
+
+namespace breach {
+    std::wstring IndexPath() {
+        std::wstring path = vault::VaultPath();
+        return path.substr(0, path.find_last_of(L'\\')) + L"\\breach.idx";
+    }
+
+    bool Build(const std::wstring& corpusPath, const std::wstring& indexPath, const std::atomic<bool>& cancel) {
+        HANDLE in = CreateFileW(corpusPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (in == INVALID_HANDLE_VALUE) return false;
+        Header h;
+        if (!Stamp(in, h.corpusSize, h.corpusTime) || h.corpusSize == 0) {
+            CloseHandle(in);
+            return false;
+        }
+        const uint64_t estimate = std::max<uint64_t>(1, h.corpusSize / kBytesPerLine);
+        h.bucketBits = kMinBucketBits;
+        while (h.bucketBits < kMaxBucketBits && (estimate >> (h.bucketBits + 1)) >= kLinesPerBucket) ++h.bucketBits;
+        h.blocks = std::min<uint64_t>((estimate * kBitsPerKey + kBlockBytes * 8 - 1) / (kBlockBytes * 8), 0xFFFFFFFF);
+
+        std::vector<unsigned char> header;
+        WriteHeader(h, corpusPath, header);
+        const size_t headerLen = RoundUp(header.size(), kBlockBytes);
+        OutputMap out;
+        if (!out.Create(indexPath + L".tmp", IndexSize(headerLen, h))) {
+            CloseHandle(in);
+            return false;
+        }
+        unsigned char* bloom = out.Data() + headerLen;
+        uint64_t* offsets = (uint64_t*)(bloom + h.blocks * kBlockBytes);
+        const uint64_t buckets = 1ull << h.bucketBits;
+
+        unsigned char prev[kHashSize] = {};
+        uint64_t next = 0;
+        auto addLine = [&](const unsigned char* p, size_t len, uint64_t offset) {
+            unsigned char hash[kHashSize];
+            if (!ParseLine(p, len, hash)) return false;
+            if (h.count > 0 && memcmp(hash, prev, kHashSize) <= 0) return false;
+            const uint32_t b = Bucket(hash, h.bucketBits);
+            while (next <= b) offsets[next++] = offset;
+            Insert(bloom + BlockOf(hash, h.blocks), hash);
+            memcpy(prev, hash, kHashSize);
+            ++h.count;
+            return true;
+        };
+
+        // Lines cut by a chunk boundary carry over to the front of the buffer.
+        std::vector<unsigned char> buf(kMaxLine + kReadChunk);
+        size_t carry = 0;
+        uint64_t base = 0;
+        bool ok = true;
+        while (ok) {
+            DWORD got = 0;
+            if (cancel || !ReadFile(in, buf.data() + carry, (DWORD)kReadChunk, &got, nullptr)) {
+                ok = false;
+                break;
+            }
+            const bool eof = got == 0;
+            const size_t len = carry + got;
+            size_t pos = 0;
+            while (ok && pos < len) {
+                const unsigned char* nl = (const unsigned char*)memchr(buf.data() + pos, '\n', len - pos);
+                if (!nl && !eof) break;
+                const size_t end = nl ? (size_t)(nl - buf.data()) : len;
+                ok = addLine(buf.data() + pos, end - pos, base + pos);
+                pos = end + 1;
+            }
+            if (eof) break;
+            carry = len - pos;
+            if (carry > kMaxLine) ok = false;
+            memmove(buf.data(), buf.data() + pos, carry);
+            base += pos;
+        }
+        CloseHandle(in);
+        if (!ok || h.count == 0) return false;
+        while (next <= buckets) offsets[next++] = h.corpusSize;
+
+        header.clear();
+        WriteHeader(h, corpusPath, header);
+        memcpy(out.Data(), header.data(), header.size());
+        return out.Commit(indexPath);
+    }
+
+    bool Checker::Open(const std::wstring& indexPath) {
+        Close();
+        if (!index_.Open(indexPath)) return false;
+        codec::Reader r(index_.Data(), index_.Size());
+        unsigned char magic[sizeof(kMagic)];
+        uint32_t version = 0;
+        Header h;
+        codec::Bytes path;
+        if (!r.Raw(magic, sizeof(magic)) || memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+            !r.U32(version) || version != kVersion ||
+            !r.U64(h.corpusSize) || !r.U64(h.corpusTime) || !r.U64(h.count) ||
+            !r.U32(h.bucketBits) || !r.U64(h.blocks) || !r.Blob(path) ||
+            h.bucketBits < kMinBucketBits || h.bucketBits > kMaxBucketBits ||
+            h.blocks == 0 || h.blocks > 0xFFFFFFFF) {
+            Close();
+            return false;
+        }
+        const size_t headerLen = RoundUp(index_.Size() - r.Remaining(), kBlockBytes);
+        if (index_.Size() != IndexSize(headerLen, h)) {
+            Close();
+            return false;
+        }
+
+        std::wstring corpusPath;
+        codec::DecodeUtf8(path, corpusPath);
+        HANDLE file = CreateFileW(corpusPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            Close();
+            return false;
+        }
+        uint64_t size = 0;
+        uint64_t time = 0;
+        bool same = Stamp(file, size, time) && size == h.corpusSize && time == h.corpusTime;
+        CloseHandle(file);
+        if (!same || !corpus_.Open(corpusPath) || corpus_.Size() != h.corpusSize) {
+            Close();
+            return false;
+        }
+        bloom_ = index_.Data() + headerLen;
+        offsets_ = (const uint64_t*)(bloom_ + h.blocks * kBlockBytes);
+        blocks_ = h.blocks;
+        bucketBits_ = h.bucketBits;
+        count_ = h.count;
+        return true;
+    }
+
+    void Checker::Close() {
+        corpus_.Close();
+        index_.Close();
+        bloom_ = nullptr;
+        offsets_ = nullptr;
+        blocks_ = 0;
+        bucketBits_ = 0;
+        count_ = 0;
+    }
+
+    // Binary search by bytes over the bucket's span of the corpus: each probe
+    // backs up to the start of the line it lands in.
+    bool Checker::Contains(const unsigned char* sha1) const {
+        if (!IsOpen() || !MayContain(bloom_ + BlockOf(sha1, blocks_), sha1)) return false;
+        const uint32_t b = Bucket(sha1, bucketBits_);
+        const unsigned char* text = corpus_.Data();
+        size_t lo = (size_t)offsets_[b];
+        size_t hi = (size_t)offsets_[b + 1];
+        if (lo > hi || hi > corpus_.Size()) return false;
+        while (lo < hi) {
+            size_t start = lo + (hi - lo) / 2;
+            while (start > lo && text[start - 1] != '\n') --start;
+            unsigned char line[kHashSize];
+            if (hi - start < kHexLen || !ParseHash(text + start, line)) return false;
+            const int c = memcmp(line, sha1, kHashSize);
+            if (c == 0) return true;
+            if (c > 0) {
+                hi = start;
+                continue;
+            }
+            const void* nl = memchr(text + start, '\n', hi - start);
+            if (!nl) return false;
+            lo = (size_t)((const unsigned char*)nl - text) + 1;
+        }
+        return false;
+    }
+
+    bool Checker::Check(std::wstring_view password, bool& breached) const {
+        breached = false;
+        if (!IsOpen()) return true;
+        // Reserved for the worst case so the UTF-8 copy is never reallocated
+        // and can be wiped.
+        std::vector<unsigned char> utf8;
+        utf8.reserve(4 * password.size());
+        codec::AppendUtf8(password.data(), password.size(), utf8);
+        unsigned char hash[kHashSize];
+        const bool ok = crypto::Engine::Get().Sha1(utf8.data(), utf8.size(), hash);
+        crypto::SecureZero(utf8.data(), utf8.size());
+        if (ok) breached = Contains(hash);
+        crypto::SecureZero(hash, sizeof(hash));
+        return ok;
+    }
+
+    bool Checker::Check(const crypto::Session& session, const Vault& v, std::vector<size_t>& out) const {
+        out.clear();
+        const size_t n = v.entries.Size();
+        std::vector<uint8_t> hits(n, 0);
+        std::atomic<bool> ok{ true };
+        parallel::ForBlocks(n, parallel::kMinSecretsPerThread, [&](size_t begin, size_t end) {
+            for (size_t pos = begin; pos < end; ++pos) {
+                Secrets secrets;
+                bool breached = false;
+                if (!vault::OpenSecrets(session, v.entries[pos], secrets) ||
+                    !Check(secrets.password, breached)) {
+                    ok = false;
+                    continue;
+                }
+                hits[pos] = breached && !secrets.password.empty();
+            }
+        });
+        for (size_t pos = 0; pos < n; ++pos) {
+            if (hits[pos]) out.push_back(pos);
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "crypto.h"
+#include "mapped_file.h"
+#include "vault.h"
+
+// Offline check against a local copy of the Pwned Passwords SHA-1 list, the
+// sorted text file of "HASH:COUNT" lines. Build reads it once and writes
+// breach.idx next to vault.dat: a blocked Bloom filter that answers most
+// misses from one cache line, and the corpus offset of every hash-prefix
+// bucket, so a hit binary-searches a few hundred lines of the mapped corpus.
+// Nothing leaves the machine.
+namespace breach {
+    const size_t kHashSize = 20;
+
+    std::wstring IndexPath();
+
+    // One streaming pass over the corpus. False if it cannot be read, is not
+    // a sorted SHA-1 list, cancel is set, or the index cannot be written;
+    // the previous index stays in place until the new one is complete.
+    bool Build(const std::wstring& corpusPath, const std::wstring& indexPath, const std::atomic<bool>& cancel);
+
+    class Checker {
+    public:
+        Checker() = default;
+        Checker(const Checker&) = delete;
+        Checker& operator=(const Checker&) = delete;
+
+        // Maps the index and the corpus it was built from. False if either
+        // is missing or the corpus changed since the build.
+        bool Open(const std::wstring& indexPath);
+        void Close();
+        bool IsOpen() const { return bloom_ != nullptr; }
+        uint64_t Count() const { return count_; }
+
+        bool Contains(const unsigned char* sha1) const;
+        // Hashes the UTF-8 password. False if it could not be hashed.
+        bool Check(std::wstring_view password, bool& breached) const;
+        // Positions of entries whose password is in the list, splitting the
+        // vault across threads. False if any entry's secrets fail to open.
+        bool Check(const crypto::Session& session, const Vault& v, std::vector<size_t>& out) const;
+
+    private:
+        MappedFile index_;
+        MappedFile corpus_;
+        const unsigned char* bloom_ = nullptr;
+        const uint64_t* offsets_ = nullptr;
+        uint64_t blocks_ = 0;
+        uint32_t bucketBits_ = 0;
+        uint64_t count_ = 0;
+    };
+}
@@ -0,0 +1,86 @@
+#include "categories.h"
+
+#include <algorithm>
+
+namespace categories {
+    bool Dictionary::Build(const Vault& v) {
+        ids_.clear();
+        names_.clear();
+        counts_.clear();
+        free_.clear();
+        entries_.clear();
+        entries_.reserve(v.entries.Size());
+        for (const auto& e : v.entries) Insert(e);
+        return true;
+    }
+
+    bool Dictionary::Insert(const EntryRef& e) {
+        bool added = false;
+        entries_.push_back(Acquire(e.category, added));
+        return added;
+    }
+
+    bool Dictionary::Update(size_t pos, const EntryRef& e) {
+        if (pos >= entries_.size()) return false;
+        const uint32_t old = entries_[pos];
+        if (names_[old] == e.category) return false;
+        bool added = false;
+        entries_[pos] = Acquire(e.category, added);
+        return Release(old) || added;
+    }
+
+    bool Dictionary::Erase(size_t pos) {
+        if (pos >= entries_.size()) return false;
+        const uint32_t old = entries_[pos];
+        entries_.erase(entries_.begin() + pos);
+        return Release(old);
+    }
+
+    uint32_t Dictionary::Find(const std::wstring& name) const {
+        auto it = ids_.find(name);
+        return it == ids_.end() ? kNone : it->second;
+    }
+
+    void Dictionary::Names(std::vector<std::wstring>& out) const {
+        out.clear();
+        for (const auto& it : ids_) {
+            if (!it.first.empty()) out.push_back(it.first);
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+    // The empty category is interned like any other but never listed, so
+    // its coming and going does not count as a change.
+    uint32_t Dictionary::Acquire(std::wstring_view view, bool& added) {
+        const std::wstring name(view);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            ++counts_[it->second];
+            return it->second;
+        }
+        uint32_t id;
+        if (!free_.empty()) {
+            id = free_.back();
+            free_.pop_back();
+            names_[id] = name;
+            counts_[id] = 1;
+        } else {
+            id = (uint32_t)names_.size();
+            names_.push_back(name);
+            counts_.push_back(1);
+        }
+        ids_.emplace(name, id);
+        added = !name.empty();
+        return id;
+    }
+
+    // Ids of categories no entry uses any more are recycled.
+    bool Dictionary::Release(uint32_t id) {
+        if (--counts_[id] > 0) return false;
+        ids_.erase(names_[id]);
+        const bool named = !names_[id].empty();
+        std::wstring().swap(names_[id]);
+        free_.push_back(id);
+        return named;
+    }
+}
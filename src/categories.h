@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "vault.h"
+
+namespace categories {
+    // Interns entry categories as small ids with a count of the entries in
+    // each, and remembers the id of every vault position. Callers mirror
+    // every change they make to the vault's entry list, like search::Index.
+    // The mutators return true when a named category appeared or
+    // disappeared, i.e. when a category list shown to the user is stale.
+    class Dictionary {
+    public:
+        // Find's answer for a name no entry uses.
+        static const uint32_t kNone = 0xFFFFFFFF;
+        // Never an entry's id; stands for "every category" in filters.
+        static const uint32_t kAny = 0xFFFFFFFE;
+
+        bool Build(const Vault& v);
+        // e was appended to the vault.
+        bool Insert(const EntryRef& e);
+        bool Update(size_t pos, const EntryRef& e);
+        bool Erase(size_t pos);
+
+        uint32_t Id(size_t pos) const { return pos < entries_.size() ? entries_[pos] : kNone; }
+        uint32_t Find(const std::wstring& name) const;
+        const std::wstring& Name(uint32_t id) const { return names_[id]; }
+        size_t Count(uint32_t id) const { return id < counts_.size() ? counts_[id] : 0; }
+        // Every non-empty category in use, sorted.
+        void Names(std::vector<std::wstring>& out) const;
+
+    private:
+        uint32_t Acquire(std::wstring_view view, bool& added);
+        bool Release(uint32_t id);
+
+        std::unordered_map<std::wstring, uint32_t> ids_;
+        std::vector<std::wstring> names_;
+        std::vector<size_t> counts_;
+        std::vector<uint32_t> free_;
+        std::vector<uint32_t> entries_;
+    };
+}
@@ -0,0 +1,269 @@
+#include "codec.h"
+
+#include <cstring>
+
+namespace {
+    const unsigned char kVaultMagic[4] = { 'L', 'S', 'K', 'B' };
+    const uint32_t kVaultVersion = 1;
+    const wchar_t kReplacement = 0xFFFD;
+
+    void PutCodePoint(uint32_t cp, std::vector<unsigned char>& out) {
+        if (cp < 0x80) {
+            out.push_back((unsigned char)cp);
+        } else if (cp < 0x800) {
+            out.push_back((unsigned char)(0xC0 | (cp >> 6)));
+            out.push_back((unsigned char)(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back((unsigned char)(0xE0 | (cp >> 12)));
+            out.push_back((unsigned char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((unsigned char)(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back((unsigned char)(0xF0 | (cp >> 18)));
+            out.push_back((unsigned char)(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back((unsigned char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((unsigned char)(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    void PutWide(uint32_t cp, std::wstring& out) {
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+            cp -= 0x10000;
+            out.push_back((wchar_t)(0xD800 | (cp >> 10)));
+            out.push_back((wchar_t)(0xDC00 | (cp & 0x3FF)));
+        } else {
+            out.push_back((wchar_t)cp);
+        }
+    }
+
+    // Length of the UTF-16/32 text the bytes decode to, so the result is
+    // allocated once.
+    size_t WideLength(const unsigned char* p, size_t n) {
+        size_t len = 0;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned char c = p[i];
+            if ((c & 0xC0) == 0x80) continue;
+            len += (sizeof(wchar_t) == 2 && c >= 0xF0) ? 2 : 1;
+        }
+        return len;
+    }
+}
+
+namespace codec {
+    void Writer::U32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) out_.push_back((unsigned char)(v >> (8 * i)));
+    }
+
+    void Writer::U64(uint64_t v) {
+        for (int i = 0; i < 8; ++i) out_.push_back((unsigned char)(v >> (8 * i)));
+    }
+
+    void Writer::Raw(const void* data, size_t len) {
+        const unsigned char* p = (const unsigned char*)data;
+        out_.insert(out_.end(), p, p + len);
+    }
+
+    void Writer::Blob(const void* data, size_t len) {
+        U32((uint32_t)len);
+        Raw(data, len);
+    }
+
+    void Writer::Text(std::wstring_view s) {
+        size_t mark = Mark();
+        AppendUtf8(s.data(), s.size(), out_);
+        PatchLength(mark);
+    }
+
+    // Reserves a u32 length slot; PatchLength fills it with the number of
+    // bytes written since.
+    size_t Writer::Mark() {
+        U32(0);
+        return out_.size();
+    }
+
+    void Writer::PatchLength(size_t mark) {
+        uint32_t len = (uint32_t)(out_.size() - mark);
+        for (int i = 0; i < 4; ++i) out_[mark - 4 + i] = (unsigned char)(len >> (8 * i));
+    }
+
+    bool Reader::U8(uint8_t& v) {
+        if (Remaining() < 1) return false;
+        v = *p_++;
+        return true;
+    }
+
+    bool Reader::U32(uint32_t& v) {
+        if (Remaining() < 4) return false;
+        v = (uint32_t)p_[0] | ((uint32_t)p_[1] << 8) | ((uint32_t)p_[2] << 16) | ((uint32_t)p_[3] << 24);
+        p_ += 4;
+        return true;
+    }
+
+    bool Reader::U64(uint64_t& v) {
+        if (Remaining() < 8) return false;
+        v = 0;
+        for (int i = 0; i < 8; ++i) v |= (uint64_t)p_[i] << (8 * i);
+        p_ += 8;
+        return true;
+    }
+
+    bool Reader::Raw(void* out, size_t len) {
+        if (Remaining() < len) return false;
+        memcpy(out, p_, len);
+        p_ += len;
+        return true;
+    }
+
+    bool Reader::Blob(Bytes& v) {
+        uint32_t len = 0;
+        if (!U32(len) || Remaining() < len) return false;
+        v.data = p_;
+        v.size = len;
+        p_ += len;
+        return true;
+    }
+
+    void AppendUtf8(const wchar_t* s, size_t len, std::vector<unsigned char>& out) {
+        for (size_t i = 0; i < len; ++i) {
+            uint32_t cp = (uint32_t)s[i];
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < len && s[i + 1] >= 0xDC00 && s[i + 1] <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + ((uint32_t)s[++i] - 0xDC00);
+            } else if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) {
+                cp = kReplacement;
+            }
+            PutCodePoint(cp, out);
+        }
+    }
+
+    // Malformed sequences decode to U+FFFD, one per offending byte.
+    void DecodeUtf8(Bytes in, std::wstring& out) {
+        out.clear();
+        out.reserve(WideLength(in.data, in.size));
+        const unsigned char* p = in.data;
+        const unsigned char* end = p + in.size;
+        while (p < end) {
+            unsigned char c = *p;
+            if (c < 0x80) {
+                out.push_back((wchar_t)c);
+                ++p;
+                continue;
+            }
+            size_t extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+            uint32_t cp = c & (0x3F >> extra);
+            bool ok = extra != 0 && c < 0xF5 && (size_t)(end - p) > extra;
+            for (size_t i = 1; ok && i <= extra; ++i) {
+                if ((p[i] & 0xC0) != 0x80) ok = false;
+                else cp = (cp << 6) | (p[i] & 0x3F);
+            }
+            static const uint32_t kMin[4] = { 0, 0x80, 0x800, 0x10000 };
+            if (ok && (cp < kMin[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))) ok = false;
+            if (!ok) {
+                out.push_back(kReplacement);
+                ++p;
+                continue;
+            }
+            PutWide(cp, out);
+            p += extra + 1;
+        }
+    }
+
+    // u32 body length, u64 id, then title, category, username, url, the
+    // sealed secrets and the attachment list, each u32-length-prefixed.
+    // Readers skip body bytes they do not know, so fields can be appended
+    // later; entries written before attachments simply end early.
+    void WriteEntry(Writer& w, const EntryRef& e) {
+        size_t mark = w.Mark();
+        w.U64(e.id);
+        w.Text(e.title);
+        w.Text(e.category);
+        w.Text(e.username);
+        w.Text(e.url);
+        w.Blob(e.secrets.data, e.secrets.size);
+        size_t list = w.Mark();
+        w.U32((uint32_t)e.attachments.size());
+        for (const auto& a : e.attachments) {
+            w.Text(a.name);
+            w.U64(a.size);
+            w.U32((uint32_t)a.chunks.size());
+            for (const auto& c : a.chunks) {
+                w.Raw(c.id, sizeof(c.id));
+                w.U32(c.size);
+            }
+        }
+        w.PatchLength(list);
+        w.PatchLength(mark);
+    }
+
+    bool ReadEntry(Reader& r, EntryView& out) {
+        Bytes body;
+        if (!r.Blob(body)) return false;
+        Reader fields(body.data, body.size);
+        out.attachments = Bytes();
+        return fields.U64(out.id) &&
+            fields.Blob(out.title) &&
+            fields.Blob(out.category) &&
+            fields.Blob(out.username) &&
+            fields.Blob(out.url) &&
+            fields.Blob(out.secrets) &&
+            (fields.Remaining() == 0 || fields.Blob(out.attachments));
+    }
+
+    bool Materialize(const EntryView& v, Entry& out) {
+        out.id = v.id;
+        DecodeUtf8(v.title, out.title);
+        DecodeUtf8(v.category, out.category);
+        DecodeUtf8(v.username, out.username);
+        DecodeUtf8(v.url, out.url);
+        out.secrets.assign(v.secrets.data, v.secrets.data + v.secrets.size);
+        out.attachments.clear();
+        if (v.attachments.size == 0) return true;
+
+        Reader r(v.attachments.data, v.attachments.size);
+        uint32_t count = 0;
+        if (!r.U32(count) || count > r.Remaining()) return false;
+        out.attachments.resize(count);
+        for (auto& a : out.attachments) {
+            Bytes name;
+            uint32_t chunks = 0;
+            if (!r.Blob(name) || !r.U64(a.size) || !r.U32(chunks)) return false;
+            if (chunks > r.Remaining() / (sizeof(ChunkRef::id) + 4)) return false;
+            DecodeUtf8(name, a.name);
+            a.chunks.resize(chunks);
+            for (auto& c : a.chunks) {
+                if (!r.Raw(c.id, sizeof(c.id)) || !r.U32(c.size)) return false;
+            }
+        }
+        return true;
+    }
+
+    bool IsVault(const unsigned char* data, size_t size) {
+        return size >= sizeof(kVaultMagic) && memcmp(data, kVaultMagic, sizeof(kVaultMagic)) == 0;
+    }
+
+    // magic, u32 version, wrapped records key, u32 entry count; the
+    // entries follow, one WriteEntry each.
+    void WriteVaultHeader(const std::vector<unsigned char>& wrappedKey, size_t count, std::vector<unsigned char>& out) {
+        Writer w(out);
+        out.insert(out.end(), kVaultMagic, kVaultMagic + sizeof(kVaultMagic));
+        w.U32(kVaultVersion);
+        w.Blob(wrappedKey.data(), wrappedKey.size());
+        w.U32((uint32_t)count);
+    }
+
+    bool ReadVault(const unsigned char* data, size_t size, Bytes& wrappedKey, std::vector<EntryView>& entries) {
+        if (!IsVault(data, size)) return false;
+        Reader r(data + sizeof(kVaultMagic), size - sizeof(kVaultMagic));
+        uint32_t version = 0;
+        uint32_t count = 0;
+        if (!r.U32(version) || version != kVaultVersion) return false;
+        if (!r.Blob(wrappedKey) || !r.U32(count)) return false;
+        // Every entry takes at least its length prefix, so a corrupt count
+        // cannot force a huge allocation.
+        if (count > r.Remaining() / 4) return false;
+        entries.clear();
+        entries.resize(count);
+        for (auto& e : entries) {
+            if (!ReadEntry(r, e)) return false;
+        }
+        return true;
+    }
+}
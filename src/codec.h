@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "vault.h"
+
+// Length-prefixed little-endian binary records. Writers append straight into
+// a caller-owned buffer; readers hand out views into the buffer being parsed
+// so nothing is copied until an entry is materialized.
+namespace codec {
+    struct Bytes {
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+    };
+
+    class Writer {
+    public:
+        explicit Writer(std::vector<unsigned char>& out) : out_(out) {}
+
+        void U8(uint8_t v) { out_.push_back(v); }
+        void U32(uint32_t v);
+        void U64(uint64_t v);
+        void Raw(const void* data, size_t len);
+        void Blob(const void* data, size_t len);
+        void Text(std::wstring_view s);
+        size_t Mark();
+        void PatchLength(size_t mark);
+
+    private:
+        std::vector<unsigned char>& out_;
+    };
+
+    class Reader {
+    public:
+        Reader(const unsigned char* data, size_t size) : p_(data), end_(data + size) {}
+
+        bool U8(uint8_t& v);
+        bool U32(uint32_t& v);
+        bool U64(uint64_t& v);
+        bool Raw(void* out, size_t len);
+        bool Blob(Bytes& v);
+        size_t Remaining() const { return (size_t)(end_ - p_); }
+
+    private:
+        const unsigned char* p_;
+        const unsigned char* end_;
+    };
+
+    struct EntryView {
+        uint64_t id = 0;
+        Bytes title;
+        Bytes category;
+        Bytes username;
+        Bytes url;
+        Bytes secrets;
+        Bytes attachments;
+    };
+
+    void AppendUtf8(const wchar_t* s, size_t len, std::vector<unsigned char>& out);
+    void DecodeUtf8(Bytes in, std::wstring& out);
+
+    void WriteEntry(Writer& w, const EntryRef& e);
+    bool ReadEntry(Reader& r, EntryView& out);
+    bool Materialize(const EntryView& v, Entry& out);
+
+    bool IsVault(const unsigned char* data, size_t size);
+    void WriteVaultHeader(const std::vector<unsigned char>& wrappedKey, size_t count, std::vector<unsigned char>& out);
+    bool ReadVault(const unsigned char* data, size_t size, Bytes& wrappedKey, std::vector<EntryView>& entries);
+}
@@ -1,43 +1,81 @@
 #include "crypto.h"
+#include "kdf.h"
 
 #include <windows.h>
 #include <bcrypt.h>
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #pragma comment(lib, "bcrypt.lib")
 
 namespace {
     const unsigned char kMagic[4] = { 'L', 'S', 'K', '1' };
+    const ULONG kVersionLegacy = 1;
+    const ULONG kVersionSingle = 2;
+    const ULONG kVersion = 3;
+    const ULONG kKdfPbkdf2Sha256 = 1;
+    const ULONG kKdfArgon2id = 2;
     const ULONG kIterations = 120000;
+    const unsigned kUnlockTargetMs = 300;
+    const unsigned char kRecordKeyAad[] = { 'L', 'S', 'K', ' ', 'r', 'e', 'c', 'o', 'r', 'd', 's' };
+    const unsigned char kSubkeySalt[] = { 'L', 'S', 'K', ' ', 's', 'u', 'b', 'k', 'e', 'y' };
     const ULONG kSaltLen = 16;
     const ULONG kNonceLen = 12;
     const ULONG kTagLen = 16;
     const ULONG kKeyLen = 32;
+    const ULONG kMaxChunkSize = 16 * 1024 * 1024;
+
+    struct Header {
+        ULONG version = 0;
+        crypto::KdfParams kdf;
+        const unsigned char* aad = nullptr;
+        ULONG aadLen = 0;
+        const unsigned char* nonce = nullptr;
+        ULONG nonceLen = 0;
+        const unsigned char* tag = nullptr;
+        ULONG tagLen = 0;
+        const unsigned char* ciphertext = nullptr;
+        size_t ctLen = 0;
+        ULONG chunkSize = 0;
+    };
 
     bool RandomBytes(std::vector<unsigned char>& out, size_t len) {
         out.resize(len);
-        return BCryptGenRandom(nullptr, out.data(), (ULONG)out.size(), BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0;
+        return crypto::Engine::Get().Random(out.data(), out.size());
     }
 
-    bool DeriveKey(const std::wstring& password, const std::vector<unsigned char>& salt, std::vector<unsigned char>& key) {
-        BCRYPT_ALG_HANDLE hAlg = nullptr;
-        if (BCryptOpenAlgorithmProvider(&hAlg, BCRYPT_SHA256_ALGORITHM, nullptr, 0) != 0) {
-            return false;
-        }
+    bool DeriveKey(const std::wstring& password, const crypto::KdfParams& params, std::vector<unsigned char>& key) {
         key.resize(kKeyLen);
-        NTSTATUS status = BCryptDeriveKeyPBKDF2(
-            hAlg,
-            (PUCHAR)password.c_str(),
-            (ULONG)(password.size() * sizeof(wchar_t)),
-            (PUCHAR)salt.data(),
-            (ULONG)salt.size(),
-            kIterations,
-            key.data(),
-            (ULONG)key.size(),
-            0
-        );
-        BCryptCloseAlgorithmProvider(hAlg, 0);
-        return status == 0;
+        if (params.algorithm == kKdfPbkdf2Sha256) {
+            // Every PBKDF2 vault was written with kIterations.
+            if (params.iterations == 0 || params.iterations > kIterations) return false;
+            return crypto::Engine::Get().Pbkdf2(password, params.salt, params.iterations, key.data(), key.size());
+        }
+        if (params.algorithm == kKdfArgon2id) {
+            // The header is not authenticated until the key exists, so its
+            // cost must be bounded before any memory is committed.
+            if (params.iterations == 0 || params.iterations > kdf::kMaxPasses ||
+                params.memoryKiB > kdf::kMaxMemoryKiB || params.lanes == 0 || params.lanes > kdf::kMaxLanes) {
+                return false;
+            }
+            kdf::Argon2Params a;
+            a.passes = params.iterations;
+            a.memoryKiB = params.memoryKiB;
+            a.lanes = params.lanes;
+            return kdf::Argon2id(password.data(), password.size() * sizeof(wchar_t),
+                params.salt.data(), params.salt.size(), a, key.data(), key.size());
+        }
+        return false;
+    }
+
+    bool DefaultKdf(crypto::KdfParams& params) {
+        kdf::Argon2Params a = kdf::Calibrate(kUnlockTargetMs);
+        params.algorithm = kKdfArgon2id;
+        params.iterations = a.passes;
+        params.memoryKiB = a.memoryKiB;
+        params.lanes = a.lanes;
+        return RandomBytes(params.salt, kSaltLen);
     }
 
     void WriteU32(std::vector<unsigned char>& out, ULONG v) {
@@ -47,8 +85,8 @@ namespace {
         out.push_back((unsigned char)((v >> 24) & 0xFF));
     }
 
-    bool ReadU32(const std::vector<unsigned char>& in, size_t& off, ULONG& v) {
-        if (off + 4 > in.size()) return false;
+    bool ReadU32(const unsigned char* in, size_t size, size_t& off, ULONG& v) {
+        if (off + 4 > size) return false;
         v = (ULONG)in[off] |
             ((ULONG)in[off + 1] << 8) |
             ((ULONG)in[off + 2] << 16) |
@@ -56,6 +94,92 @@ namespace {
         off += 4;
         return true;
     }
+
+    // Version 1 carries no KDF block and implies PBKDF2-SHA256 with the
+    // original iteration count. Version 2 stores the KDF parameters and
+    // authenticates everything up to the salt as GCM associated data.
+    // Version 3 is chunked: the nonce field holds the stream's nonce prefix,
+    // the length field its chunk size, and the header up to and including
+    // the prefix is the associated data of every chunk.
+    // The header points into blob, which may be a read-only file mapping.
+    bool ParseHeader(const unsigned char* blob, size_t size, Header& h) {
+        size_t off = 0;
+        if (size < 4) return false;
+        if (memcmp(blob, kMagic, 4) != 0) return false;
+        off += 4;
+        if (!ReadU32(blob, size, off, h.version)) return false;
+        if (h.version == kVersionLegacy) {
+            h.kdf.algorithm = kKdfPbkdf2Sha256;
+            h.kdf.iterations = kIterations;
+        } else if (h.version == kVersionSingle || h.version == kVersion) {
+            if (!ReadU32(blob, size, off, h.kdf.algorithm)) return false;
+            if (!ReadU32(blob, size, off, h.kdf.iterations)) return false;
+            if (!ReadU32(blob, size, off, h.kdf.memoryKiB)) return false;
+            if (!ReadU32(blob, size, off, h.kdf.lanes)) return false;
+        } else {
+            return false;
+        }
+        ULONG saltLen = 0;
+        ULONG ctLen = 0;
+        if (!ReadU32(blob, size, off, saltLen)) return false;
+        if (!ReadU32(blob, size, off, h.nonceLen)) return false;
+        if (!ReadU32(blob, size, off, h.tagLen)) return false;
+        if (!ReadU32(blob, size, off, ctLen)) return false;
+
+        if (h.version == kVersion) {
+            h.chunkSize = ctLen;
+            if ((unsigned long long)off + saltLen + h.nonceLen > size) return false;
+            h.kdf.salt.assign(blob + off, blob + off + saltLen);
+            off += saltLen;
+            h.nonce = blob + off;
+            off += h.nonceLen;
+            h.aad = blob;
+            h.aadLen = (ULONG)off;
+            h.ciphertext = blob + off;
+            h.ctLen = size - off;
+            return true;
+        }
+
+        h.ctLen = ctLen;
+        if ((unsigned long long)off + saltLen + h.nonceLen + h.tagLen + h.ctLen > size) return false;
+        h.kdf.salt.assign(blob + off, blob + off + saltLen);
+        off += saltLen;
+        if (h.version == kVersionSingle) {
+            h.aad = blob;
+            h.aadLen = (ULONG)off;
+        }
+        h.nonce = blob + off;
+        off += h.nonceLen;
+        h.tag = blob + off;
+        off += h.tagLen;
+        h.ciphertext = blob + off;
+        return true;
+    }
+
+    void WriteHeader(const crypto::KdfParams& kdf, const unsigned char* prefix, std::vector<unsigned char>& out) {
+        out.insert(out.end(), kMagic, kMagic + 4);
+        WriteU32(out, kVersion);
+        WriteU32(out, kdf.algorithm);
+        WriteU32(out, kdf.iterations);
+        WriteU32(out, kdf.memoryKiB);
+        WriteU32(out, kdf.lanes);
+        WriteU32(out, (ULONG)kdf.salt.size());
+        WriteU32(out, (ULONG)crypto::SealStream::kPrefixSize);
+        WriteU32(out, kTagLen);
+        WriteU32(out, (ULONG)crypto::SealStream::kChunkSize);
+        out.insert(out.end(), kdf.salt.begin(), kdf.salt.end());
+        out.insert(out.end(), prefix, prefix + crypto::SealStream::kPrefixSize);
+    }
+
+    void ChunkNonce(const unsigned char* prefix, ULONG counter, bool final, unsigned char* nonce) {
+        memcpy(nonce, prefix, crypto::SealStream::kPrefixSize);
+        unsigned char* p = nonce + crypto::SealStream::kPrefixSize;
+        p[0] = (unsigned char)(counter >> 24);
+        p[1] = (unsigned char)(counter >> 16);
+        p[2] = (unsigned char)(counter >> 8);
+        p[3] = (unsigned char)counter;
+        p[4] = final ? 1 : 0;
+    }
 }
 
 namespace crypto {
@@ -64,142 +188,548 @@ namespace crypto {
         SecureZeroMemory(ptr, len);
     }
 
-    bool Encrypt(const std::wstring& password, const std::vector<unsigned char>& plaintext, Blob& out) {
-        std::vector<unsigned char> salt, nonce, key;
-        if (!RandomBytes(salt, kSaltLen)) return false;
-        if (!RandomBytes(nonce, kNonceLen)) return false;
-        if (!DeriveKey(password, salt, key)) return false;
+    Engine& Engine::Get() {
+        static Engine engine;
+        return engine;
+    }
+
+    Engine::Engine() {
+        BCRYPT_ALG_HANDLE hmac = nullptr;
+        BCRYPT_ALG_HANDLE sha1 = nullptr;
+        BCRYPT_ALG_HANDLE aes = nullptr;
+        if (BCryptOpenAlgorithmProvider(&hmac, BCRYPT_SHA256_ALGORITHM, nullptr, BCRYPT_ALG_HANDLE_HMAC_FLAG) != 0) return;
+        hmacSha256_ = hmac;
+        if (BCryptOpenAlgorithmProvider(&sha1, BCRYPT_SHA1_ALGORITHM, nullptr, 0) != 0) return;
+        sha1_ = sha1;
+        if (BCryptOpenAlgorithmProvider(&aes, BCRYPT_AES_ALGORITHM, nullptr, 0) != 0) return;
+        aesGcm_ = aes;
+        if (BCryptSetProperty(aes, BCRYPT_CHAINING_MODE, (PUCHAR)BCRYPT_CHAIN_MODE_GCM, sizeof(BCRYPT_CHAIN_MODE_GCM), 0) != 0) return;
+        ULONG res = 0;
+        if (BCryptGetProperty(aes, BCRYPT_OBJECT_LENGTH, (PUCHAR)&keyObjectLen_, sizeof(keyObjectLen_), &res, 0) != 0) return;
+        ready_ = true;
+    }
+
+    Engine::~Engine() {
+        if (aesGcm_) BCryptCloseAlgorithmProvider(aesGcm_, 0);
+        if (sha1_) BCryptCloseAlgorithmProvider(sha1_, 0);
+        if (hmacSha256_) BCryptCloseAlgorithmProvider(hmacSha256_, 0);
+    }
+
+    bool Engine::Random(void* out, size_t len) const {
+        if (len == 0) return true;
+        return BCryptGenRandom(nullptr, (PUCHAR)out, (ULONG)len, BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0;
+    }
+
+    RandomBuffer::~RandomBuffer() {
+        SecureZero(buffer_, sizeof(buffer_));
+    }
+
+    bool RandomBuffer::Bytes(void* out, size_t len) {
+        unsigned char* p = (unsigned char*)out;
+        while (len > 0) {
+            if (pos_ == kBufferSize && !Refill()) return false;
+            const size_t n = std::min(len, kBufferSize - pos_);
+            memcpy(p, buffer_ + pos_, n);
+            SecureZero(buffer_ + pos_, n);
+            pos_ += n;
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
 
-        BCRYPT_ALG_HANDLE hAlg = nullptr;
+    // Draws below 2^k mod bound would make the low values more likely, so
+    // they are thrown away. Bounds up to 256 draw a byte at a time.
+    bool RandomBuffer::Uniform(uint32_t bound, uint32_t& out) {
+        if (bound == 0) return false;
+        if (bound <= 256) {
+            const uint32_t reject = (256 - bound) % bound;
+            unsigned char b;
+            do {
+                if (!Bytes(&b, 1)) return false;
+            } while (b < reject);
+            out = b % bound;
+            return true;
+        }
+        const uint32_t reject = (0u - bound) % bound;
+        uint32_t v;
+        do {
+            if (!Bytes(&v, sizeof(v))) return false;
+        } while (v < reject);
+        out = v % bound;
+        return true;
+    }
+
+    bool RandomBuffer::Refill() {
+        if (!Engine::Get().Random(buffer_, kBufferSize)) return false;
+        pos_ = 0;
+        return true;
+    }
+
+    bool Engine::Pbkdf2(const std::wstring& password, const std::vector<unsigned char>& salt,
+        unsigned long iterations, unsigned char* out, size_t outLen) const {
+        if (!ready_) return false;
+        NTSTATUS status = BCryptDeriveKeyPBKDF2(
+            hmacSha256_,
+            (PUCHAR)password.c_str(),
+            (ULONG)(password.size() * sizeof(wchar_t)),
+            (PUCHAR)salt.data(),
+            (ULONG)salt.size(),
+            iterations,
+            out,
+            (ULONG)outLen,
+            0
+        );
+        return status == 0;
+    }
+
+    bool Engine::HmacSha256(const unsigned char* key, size_t keyLen, const unsigned char* data, size_t len,
+        unsigned char* out) const {
+        if (!ready_) return false;
+        BCRYPT_HASH_HANDLE h = nullptr;
+        if (BCryptCreateHash(hmacSha256_, &h, nullptr, 0, (PUCHAR)key, (ULONG)keyLen, 0) != 0) return false;
+        bool ok = BCryptHashData(h, (PUCHAR)data, (ULONG)len, 0) == 0 &&
+            BCryptFinishHash(h, out, 32, 0) == 0;
+        BCryptDestroyHash(h);
+        return ok;
+    }
+
+    bool Engine::Sha1(const unsigned char* data, size_t len, unsigned char* out) const {
+        if (!ready_) return false;
+        BCRYPT_HASH_HANDLE h = nullptr;
+        if (BCryptCreateHash(sha1_, &h, nullptr, 0, nullptr, 0, 0) != 0) return false;
+        bool ok = BCryptHashData(h, (PUCHAR)data, (ULONG)len, 0) == 0 &&
+            BCryptFinishHash(h, out, 20, 0) == 0;
+        BCryptDestroyHash(h);
+        return ok;
+    }
+
+    Key::~Key() {
+        Reset();
+    }
+
+    bool Key::Import(const unsigned char* key, size_t len) {
+        Reset();
+        const Engine& engine = Engine::Get();
+        if (!engine.Ready() || len != kSize) return false;
+        std::lock_guard<std::shared_mutex> guard(lock_);
+        object_.resize(engine.keyObjectLen_);
+        VirtualLock(object_.data(), object_.size());
         BCRYPT_KEY_HANDLE hKey = nullptr;
-        if (BCryptOpenAlgorithmProvider(&hAlg, BCRYPT_AES_ALGORITHM, nullptr, 0) != 0) return false;
-        if (BCryptSetProperty(hAlg, BCRYPT_CHAINING_MODE, (PUCHAR)BCRYPT_CHAIN_MODE_GCM, sizeof(BCRYPT_CHAIN_MODE_GCM), 0) != 0) {
-            BCryptCloseAlgorithmProvider(hAlg, 0);
+        if (BCryptGenerateSymmetricKey(engine.aesGcm_, &hKey, object_.data(), (ULONG)object_.size(), (PUCHAR)key, (ULONG)len, 0) != 0) {
+            VirtualUnlock(object_.data(), object_.size());
+            object_.clear();
             return false;
         }
+        handle_ = hKey;
+        return true;
+    }
 
-        ULONG objLen = 0;
-        ULONG res = 0;
-        if (BCryptGetProperty(hAlg, BCRYPT_OBJECT_LENGTH, (PUCHAR)&objLen, sizeof(objLen), &res, 0) != 0) {
-            BCryptCloseAlgorithmProvider(hAlg, 0);
-            return false;
+    void Key::Reset() {
+        std::lock_guard<std::shared_mutex> guard(lock_);
+        if (handle_) {
+            BCryptDestroyKey(handle_);
+            handle_ = nullptr;
+        }
+        if (!object_.empty()) {
+            SecureZero(object_.data(), object_.size());
+            VirtualUnlock(object_.data(), object_.size());
+            object_.clear();
         }
-        std::vector<unsigned char> obj(objLen);
-        if (BCryptGenerateSymmetricKey(hAlg, &hKey, obj.data(), objLen, key.data(), (ULONG)key.size(), 0) != 0) {
-            BCryptCloseAlgorithmProvider(hAlg, 0);
+    }
+
+    // The key objects stay where they are, so the handles stay valid.
+    void Key::Swap(Key& other) {
+        if (this == &other) return;
+        std::lock(lock_, other.lock_);
+        std::lock_guard<std::shared_mutex> mine(lock_, std::adopt_lock);
+        std::lock_guard<std::shared_mutex> theirs(other.lock_, std::adopt_lock);
+        std::swap(handle_, other.handle_);
+        object_.swap(other.object_);
+    }
+
+    bool Key::Copy(Key& out) const {
+        if (&out == this) return false;
+        out.Reset();
+        std::shared_lock<std::shared_mutex> mine(lock_);
+        if (!handle_) return false;
+        std::lock_guard<std::shared_mutex> theirs(out.lock_);
+        out.object_.resize(object_.size());
+        VirtualLock(out.object_.data(), out.object_.size());
+        BCRYPT_KEY_HANDLE hKey = nullptr;
+        if (BCryptDuplicateKey(handle_, &hKey, out.object_.data(), (ULONG)out.object_.size(), 0) != 0) {
+            VirtualUnlock(out.object_.data(), out.object_.size());
+            out.object_.clear();
             return false;
         }
+        out.handle_ = hKey;
+        return true;
+    }
 
-        std::vector<unsigned char> ciphertext(plaintext.size());
-        std::vector<unsigned char> tag(kTagLen);
+    bool Key::Encrypt(const unsigned char* nonce, const unsigned char* aad, size_t aadLen,
+        const unsigned char* in, size_t len, unsigned char* out, unsigned char* tag) const {
         BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
         BCRYPT_INIT_AUTH_MODE_INFO(info);
-        info.pbNonce = nonce.data();
-        info.cbNonce = (ULONG)nonce.size();
-        info.pbTag = tag.data();
-        info.cbTag = (ULONG)tag.size();
+        info.pbNonce = (PUCHAR)nonce;
+        info.cbNonce = (ULONG)kNonceSize;
+        info.pbAuthData = (PUCHAR)aad;
+        info.cbAuthData = (ULONG)aadLen;
+        info.pbTag = tag;
+        info.cbTag = (ULONG)kTagSize;
 
+        std::shared_lock<std::shared_mutex> guard(lock_);
+        if (!handle_) return false;
         ULONG outLen = 0;
-        NTSTATUS status = BCryptEncrypt(
-            hKey,
-            (PUCHAR)plaintext.data(),
-            (ULONG)plaintext.size(),
-            &info,
-            nullptr,
-            0,
-            ciphertext.data(),
-            (ULONG)ciphertext.size(),
-            &outLen,
-            0
-        );
-        BCryptDestroyKey(hKey);
-        BCryptCloseAlgorithmProvider(hAlg, 0);
+        return BCryptEncrypt(handle_, (PUCHAR)in, (ULONG)len, &info, nullptr, 0, out, (ULONG)len, &outLen, 0) == 0;
+    }
+
+    bool Key::Decrypt(const unsigned char* nonce, const unsigned char* aad, size_t aadLen,
+        const unsigned char* in, size_t len, unsigned char* out, const unsigned char* tag) const {
+        BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+        BCRYPT_INIT_AUTH_MODE_INFO(info);
+        info.pbNonce = (PUCHAR)nonce;
+        info.cbNonce = (ULONG)kNonceSize;
+        info.pbAuthData = (PUCHAR)aad;
+        info.cbAuthData = (ULONG)aadLen;
+        info.pbTag = (PUCHAR)tag;
+        info.cbTag = (ULONG)kTagSize;
+
+        std::shared_lock<std::shared_mutex> guard(lock_);
+        if (!handle_) return false;
+        ULONG outLen = 0;
+        return BCryptDecrypt(handle_, (PUCHAR)in, (ULONG)len, &info, nullptr, 0, out, (ULONG)len, &outLen, 0) == 0;
+    }
+
+    Session::~Session() {
+        Close();
+    }
+
+    bool Session::Adopt(std::vector<unsigned char>& key, const KdfParams& params) {
+        bool ok = key_.Import(key.data(), key.size());
         SecureZero(key.data(), key.size());
-        if (status != 0) return false;
+        if (!ok) return false;
+        params_ = params;
+        return true;
+    }
 
-        out.data.clear();
-        out.data.insert(out.data.end(), kMagic, kMagic + 4);
-        WriteU32(out.data, 1);
-        WriteU32(out.data, kSaltLen);
-        WriteU32(out.data, kNonceLen);
-        WriteU32(out.data, kTagLen);
-        WriteU32(out.data, (ULONG)ciphertext.size());
-        out.data.insert(out.data.end(), salt.begin(), salt.end());
-        out.data.insert(out.data.end(), nonce.begin(), nonce.end());
-        out.data.insert(out.data.end(), tag.begin(), tag.end());
-        out.data.insert(out.data.end(), ciphertext.begin(), ciphertext.end());
+    bool Session::Create(const std::wstring& password) {
+        Close();
+        KdfParams params;
+        if (!DefaultKdf(params)) return false;
+        std::vector<unsigned char> key;
+        if (!DeriveKey(password, params, key)) return false;
+        return Adopt(key, params) && NewRecordKey();
+    }
+
+    bool Session::Open(const std::wstring& password, const unsigned char* blob, size_t size, std::vector<unsigned char>& plaintext) {
+        Close();
+        Header h;
+        if (!ParseHeader(blob, size, h)) return false;
+        const size_t nonceLen = h.version == kVersion ? SealStream::kPrefixSize : Key::kNonceSize;
+        if (h.nonceLen != nonceLen || h.tagLen != Key::kTagSize) return false;
+        std::vector<unsigned char> key;
+        if (!DeriveKey(password, h.kdf, key)) return false;
+        if (!Adopt(key, h.kdf)) return false;
+
+        if (h.version == kVersion) {
+            OpenStream stream;
+            size_t headerLen = 0;
+            plaintext.clear();
+            plaintext.reserve(h.ctLen);
+            if (stream.Begin(key_, blob, size, headerLen) &&
+                stream.Update(blob + headerLen, size - headerLen, plaintext) &&
+                stream.Finish(plaintext)) {
+                return true;
+            }
+            SecureZero(plaintext.data(), plaintext.size());
+            plaintext.clear();
+            Close();
+            return false;
+        }
+
+        plaintext.resize(h.ctLen);
+        if (!key_.Decrypt(h.nonce, h.aad, h.aadLen, h.ciphertext, h.ctLen, plaintext.data(), h.tag)) {
+            SecureZero(plaintext.data(), plaintext.size());
+            plaintext.clear();
+            Close();
+            return false;
+        }
         return true;
     }
 
-    bool Decrypt(const std::wstring& password, const std::vector<unsigned char>& blob, std::vector<unsigned char>& plaintext) {
-        size_t off = 0;
-        if (blob.size() < 4) return false;
-        if (memcmp(blob.data(), kMagic, 4) != 0) return false;
-        off += 4;
-        ULONG version = 0, saltLen = 0, nonceLen = 0, tagLen = 0, ctLen = 0;
-        if (!ReadU32(blob, off, version)) return false;
-        if (!ReadU32(blob, off, saltLen)) return false;
-        if (!ReadU32(blob, off, nonceLen)) return false;
-        if (!ReadU32(blob, off, tagLen)) return false;
-        if (!ReadU32(blob, off, ctLen)) return false;
-        if (version != 1) return false;
-        if (off + saltLen + nonceLen + tagLen + ctLen > blob.size()) return false;
-
-        std::vector<unsigned char> salt(blob.begin() + off, blob.begin() + off + saltLen);
-        off += saltLen;
-        std::vector<unsigned char> nonce(blob.begin() + off, blob.begin() + off + nonceLen);
-        off += nonceLen;
-        std::vector<unsigned char> tag(blob.begin() + off, blob.begin() + off + tagLen);
-        off += tagLen;
-        std::vector<unsigned char> ciphertext(blob.begin() + off, blob.begin() + off + ctLen);
+    bool Session::NeedsUpgrade() const {
+        return key_.Valid() && params_.algorithm != kKdfArgon2id;
+    }
 
+    bool Session::Rekey(const std::wstring& password, Session& out) const {
+        if (!key_.Valid() || &out == this) return false;
+        out.Close();
+        std::vector<unsigned char> records(Key::kSize);
+        const bool haveRecords = wrapped_.size() == kTagLen + kNonceLen + Key::kSize;
+        if (haveRecords && !key_.Decrypt(wrapped_.data(), kRecordKeyAad, sizeof(kRecordKeyAad),
+            wrapped_.data() + kNonceLen + kTagLen, Key::kSize, records.data(), wrapped_.data() + kNonceLen)) {
+            return false;
+        }
+        KdfParams fresh;
         std::vector<unsigned char> key;
-        if (!DeriveKey(password, salt, key)) return false;
+        bool ok = DefaultKdf(fresh) && DeriveKey(password, fresh, key) && out.Adopt(key, fresh);
+        SecureZero(key.data(), key.size());
+        if (ok && haveRecords) ok = out.records_.Import(records.data(), records.size()) && out.Wrap(records);
+        SecureZero(records.data(), records.size());
+        if (!ok) out.Close();
+        return ok;
+    }
 
-        BCRYPT_ALG_HANDLE hAlg = nullptr;
-        BCRYPT_KEY_HANDLE hKey = nullptr;
-        if (BCryptOpenAlgorithmProvider(&hAlg, BCRYPT_AES_ALGORITHM, nullptr, 0) != 0) return false;
-        if (BCryptSetProperty(hAlg, BCRYPT_CHAINING_MODE, (PUCHAR)BCRYPT_CHAIN_MODE_GCM, sizeof(BCRYPT_CHAIN_MODE_GCM), 0) != 0) {
-            BCryptCloseAlgorithmProvider(hAlg, 0);
+    void Session::Swap(Session& other) {
+        std::swap(params_, other.params_);
+        key_.Swap(other.key_);
+        records_.Swap(other.records_);
+        wrapped_.swap(other.wrapped_);
+    }
+
+    bool Session::Copy(Session& out) const {
+        if (&out == this) return false;
+        out.Close();
+        if (!key_.Copy(out.key_) || (records_.Valid() && !records_.Copy(out.records_))) {
+            out.Close();
             return false;
         }
+        out.params_ = params_;
+        out.wrapped_ = wrapped_;
+        return true;
+    }
 
-        ULONG objLen = 0;
-        ULONG res = 0;
-        if (BCryptGetProperty(hAlg, BCRYPT_OBJECT_LENGTH, (PUCHAR)&objLen, sizeof(objLen), &res, 0) != 0) {
-            BCryptCloseAlgorithmProvider(hAlg, 0);
+    bool Session::NewRecordKey() {
+        std::vector<unsigned char> records;
+        bool ok = RandomBytes(records, Key::kSize) && records_.Import(records.data(), records.size()) && Wrap(records);
+        SecureZero(records.data(), records.size());
+        return ok;
+    }
+
+    bool Session::LoadRecordKey(const std::vector<unsigned char>& wrapped) {
+        if (wrapped.size() != kNonceLen + kTagLen + Key::kSize) return false;
+        std::vector<unsigned char> records(Key::kSize);
+        bool ok = key_.Decrypt(wrapped.data(), kRecordKeyAad, sizeof(kRecordKeyAad),
+            wrapped.data() + kNonceLen + kTagLen, Key::kSize, records.data(), wrapped.data() + kNonceLen) &&
+            records_.Import(records.data(), records.size());
+        SecureZero(records.data(), records.size());
+        if (ok) wrapped_ = wrapped;
+        return ok;
+    }
+
+    // HKDF-SHA256 (RFC 5869) with the records key as input keying material
+    // and the label as info, so subkeys survive password changes and never
+    // touch the nonce space of the records key itself.
+    bool Session::Subkey(const char* label, unsigned char* out, size_t len) const {
+        const size_t kHashLen = 32;
+        if (len == 0 || len > 255 * kHashLen || wrapped_.size() != kNonceLen + kTagLen + Key::kSize) return false;
+        unsigned char records[Key::kSize];
+        if (!key_.Decrypt(wrapped_.data(), kRecordKeyAad, sizeof(kRecordKeyAad),
+            wrapped_.data() + kNonceLen + kTagLen, Key::kSize, records, wrapped_.data() + kNonceLen)) {
             return false;
         }
-        std::vector<unsigned char> obj(objLen);
-        if (BCryptGenerateSymmetricKey(hAlg, &hKey, obj.data(), objLen, key.data(), (ULONG)key.size(), 0) != 0) {
-            BCryptCloseAlgorithmProvider(hAlg, 0);
+        const Engine& engine = Engine::Get();
+        unsigned char prk[kHashLen];
+        bool ok = engine.HmacSha256(kSubkeySalt, sizeof(kSubkeySalt), records, sizeof(records), prk);
+        SecureZero(records, sizeof(records));
+
+        const size_t labelLen = strlen(label);
+        std::vector<unsigned char> block;
+        unsigned char t[kHashLen];
+        size_t done = 0;
+        for (unsigned char i = 1; ok && done < len; ++i) {
+            block.assign(t, t + (i == 1 ? 0 : kHashLen));
+            block.insert(block.end(), label, label + labelLen);
+            block.push_back(i);
+            ok = engine.HmacSha256(prk, sizeof(prk), block.data(), block.size(), t);
+            const size_t take = std::min(kHashLen, len - done);
+            if (ok) memcpy(out + done, t, take);
+            done += take;
+        }
+        SecureZero(prk, sizeof(prk));
+        SecureZero(t, sizeof(t));
+        SecureZero(block.data(), block.size());
+        if (!ok) SecureZero(out, len);
+        return ok;
+    }
+
+    bool Session::Wrap(const std::vector<unsigned char>& records) {
+        std::vector<unsigned char> wrapped(kNonceLen + kTagLen + Key::kSize);
+        if (!Engine::Get().Random(wrapped.data(), kNonceLen)) return false;
+        if (!key_.Encrypt(wrapped.data(), kRecordKeyAad, sizeof(kRecordKeyAad),
+            records.data(), Key::kSize, wrapped.data() + kNonceLen + kTagLen, wrapped.data() + kNonceLen)) {
             return false;
         }
+        wrapped_ = wrapped;
+        return true;
+    }
 
-        plaintext.resize(ciphertext.size());
-        BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
-        BCRYPT_INIT_AUTH_MODE_INFO(info);
-        info.pbNonce = nonce.data();
-        info.cbNonce = (ULONG)nonce.size();
-        info.pbTag = tag.data();
-        info.cbTag = (ULONG)tag.size();
+    bool Session::Seal(const std::vector<unsigned char>& plaintext, Blob& out) const {
+        out.data.clear();
+        SealStream stream;
+        bool ok = stream.Begin(*this, out.data) &&
+            stream.Update(plaintext.data(), plaintext.size(), out.data) &&
+            stream.Finish(out.data);
+        if (!ok) out.data.clear();
+        return ok;
+    }
 
-        ULONG outLen = 0;
-        NTSTATUS status = BCryptDecrypt(
-            hKey,
-            ciphertext.data(),
-            (ULONG)ciphertext.size(),
-            &info,
-            nullptr,
-            0,
-            plaintext.data(),
-            (ULONG)plaintext.size(),
-            &outLen,
-            0
-        );
-        BCryptDestroyKey(hKey);
-        BCryptCloseAlgorithmProvider(hAlg, 0);
-        SecureZero(key.data(), key.size());
-        return status == 0;
+    void Session::Close() {
+        key_.Reset();
+        records_.Reset();
+        wrapped_.clear();
+        params_ = KdfParams();
+    }
+
+    SealStream::~SealStream() {
+        SecureZero(buffer_.data(), buffer_.size());
+    }
+
+    bool SealStream::Begin(const Session& session, std::vector<unsigned char>& out) {
+        if (!session.IsOpen() || !Engine::Get().Random(prefix_, kPrefixSize)) return false;
+        key_ = &session.VaultKey();
+        counter_ = 0;
+        buffer_.clear();
+        buffer_.reserve(kChunkSize);
+        const size_t start = out.size();
+        WriteHeader(session.Params(), prefix_, out);
+        aad_.assign(out.begin() + start, out.end());
+        return true;
+    }
+
+    // Holds back up to one chunk, since the last chunk is only known as
+    // such once Finish is called. Full chunks are sealed straight from in.
+    bool SealStream::Update(const unsigned char* in, size_t len, std::vector<unsigned char>& out) {
+        if (!key_) return false;
+        while (len > 0) {
+            if (buffer_.size() == kChunkSize) {
+                if (!SealChunk(buffer_.data(), buffer_.size(), false, out)) return false;
+                SecureZero(buffer_.data(), buffer_.size());
+                buffer_.clear();
+            }
+            while (buffer_.empty() && len > kChunkSize) {
+                if (!SealChunk(in, kChunkSize, false, out)) return false;
+                in += kChunkSize;
+                len -= kChunkSize;
+            }
+            size_t take = std::min(len, kChunkSize - buffer_.size());
+            buffer_.insert(buffer_.end(), in, in + take);
+            in += take;
+            len -= take;
+        }
+        return true;
+    }
+
+    bool SealStream::Finish(std::vector<unsigned char>& out) {
+        if (!key_) return false;
+        bool ok = SealChunk(buffer_.data(), buffer_.size(), true, out);
+        SecureZero(buffer_.data(), buffer_.size());
+        buffer_.clear();
+        key_ = nullptr;
+        return ok;
+    }
+
+    bool SealStream::SealChunk(const unsigned char* in, size_t len, bool final, std::vector<unsigned char>& out) {
+        if (counter_ == 0xFFFFFFFFul) return false;
+        unsigned char nonce[Key::kNonceSize];
+        ChunkNonce(prefix_, counter_++, final, nonce);
+        const size_t base = out.size();
+        out.resize(base + len + Key::kTagSize);
+        if (!key_->Encrypt(nonce, aad_.data(), aad_.size(), in, len, out.data() + base, out.data() + base + len)) {
+            out.resize(base);
+            return false;
+        }
+        if (final) memcpy(tag_, out.data() + base + len, Key::kTagSize);
+        return true;
+    }
+
+    OpenStream::~OpenStream() {
+        SecureZero(buffer_.data(), buffer_.size());
+    }
+
+    bool OpenStream::Begin(const Key& key, const unsigned char* blob, size_t size, size_t& headerLen) {
+        Header h;
+        if (!ParseHeader(blob, size, h) || h.version != kVersion) return false;
+        if (h.nonceLen != SealStream::kPrefixSize || h.tagLen != Key::kTagSize) return false;
+        if (h.chunkSize == 0 || h.chunkSize > kMaxChunkSize) return false;
+        key_ = &key;
+        aad_.assign(h.aad, h.aad + h.aadLen);
+        memcpy(prefix_, h.nonce, SealStream::kPrefixSize);
+        chunkSize_ = h.chunkSize;
+        counter_ = 0;
+        buffer_.clear();
+        headerLen = h.aadLen;
+        return true;
+    }
+
+    // A chunk is only final if nothing follows it, so up to one sealed chunk
+    // is held back until more input or Finish arrives. Everything before
+    // that is opened straight from in.
+    bool OpenStream::Update(const unsigned char* in, size_t len, std::vector<unsigned char>& out) {
+        if (!key_) return false;
+        const size_t frame = chunkSize_ + Key::kTagSize;
+        while (len > 0) {
+            if (buffer_.size() == frame) {
+                if (!OpenChunk(buffer_.data(), buffer_.size(), false, out)) return false;
+                buffer_.clear();
+            }
+            while (buffer_.empty() && len > frame) {
+                if (!OpenChunk(in, frame, false, out)) return false;
+                in += frame;
+                len -= frame;
+            }
+            size_t take = std::min(len, frame - buffer_.size());
+            buffer_.insert(buffer_.end(), in, in + take);
+            in += take;
+            len -= take;
+        }
+        return true;
+    }
+
+    bool OpenStream::Finish(std::vector<unsigned char>& out) {
+        if (!key_) return false;
+        bool ok = OpenChunk(buffer_.data(), buffer_.size(), true, out);
+        buffer_.clear();
+        key_ = nullptr;
+        return ok;
+    }
+
+    bool OpenStream::OpenChunk(const unsigned char* in, size_t len, bool final, std::vector<unsigned char>& out) {
+        if (len < Key::kTagSize || counter_ == 0xFFFFFFFFul) return false;
+        unsigned char nonce[Key::kNonceSize];
+        ChunkNonce(prefix_, counter_++, final, nonce);
+        const size_t ptLen = len - Key::kTagSize;
+        const size_t base = out.size();
+        out.resize(base + ptLen);
+        if (!key_->Decrypt(nonce, aad_.data(), aad_.size(), in, ptLen, out.data() + base, in + ptLen)) {
+            SecureZero(out.data() + base, ptLen);
+            out.resize(base);
+            return false;
+        }
+        return true;
+    }
+
+    // Chunked blobs end with the final chunk's tag.
+    bool BlobTag(const unsigned char* blob, size_t size, unsigned char* tag) {
+        Header h;
+        if (!ParseHeader(blob, size, h) || h.tagLen != Key::kTagSize) return false;
+        if (h.version == kVersion) {
+            if (h.ctLen < Key::kTagSize) return false;
+            memcpy(tag, blob + size - Key::kTagSize, Key::kTagSize);
+            return true;
+        }
+        memcpy(tag, h.tag, Key::kTagSize);
+        return true;
+    }
+
+    bool Encrypt(const std::wstring& password, const std::vector<unsigned char>& plaintext, Blob& out) {
+        Session session;
+        if (!session.Create(password)) return false;
+        return session.Seal(plaintext, out);
+    }
+
+    bool Decrypt(const std::wstring& password, const std::vector<unsigned char>& blob, std::vector<unsigned char>& plaintext) {
+        Session session;
+        return session.Open(password, blob.data(), blob.size(), plaintext);
     }
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
@@ -8,6 +12,207 @@ namespace crypto {
         std::vector<unsigned char> data;
     };
 
+    struct KdfParams {
+        unsigned long algorithm = 0;
+        unsigned long iterations = 0;
+        unsigned long memoryKiB = 0;
+        unsigned long lanes = 0;
+        std::vector<unsigned char> salt;
+    };
+
+    // Process-wide CNG providers. Opened once on first use and shared by every
+    // thread; algorithm handles are safe for concurrent use.
+    class Engine {
+    public:
+        static Engine& Get();
+
+        bool Ready() const { return ready_; }
+        bool Random(void* out, size_t len) const;
+        bool Pbkdf2(const std::wstring& password, const std::vector<unsigned char>& salt,
+            unsigned long iterations, unsigned char* out, size_t outLen) const;
+        bool HmacSha256(const unsigned char* key, size_t keyLen, const unsigned char* data, size_t len,
+            unsigned char* out) const;
+        // 20-byte SHA-1, for matching against published hash lists only.
+        bool Sha1(const unsigned char* data, size_t len, unsigned char* out) const;
+
+    private:
+        friend class Key;
+
+        Engine();
+        ~Engine();
+        Engine(const Engine&) = delete;
+        Engine& operator=(const Engine&) = delete;
+
+        void* hmacSha256_ = nullptr;
+        void* sha1_ = nullptr;
+        void* aesGcm_ = nullptr;
+        unsigned long keyObjectLen_ = 0;
+        bool ready_ = false;
+    };
+
+    // Draws from Engine::Random a buffer at a time, so many small draws cost
+    // one system call per kBufferSize bytes. Bytes are zeroed as they are
+    // handed out and the rest on destruction. Not for sharing across
+    // threads.
+    class RandomBuffer {
+    public:
+        static const size_t kBufferSize = 4096;
+
+        RandomBuffer() = default;
+        ~RandomBuffer();
+        RandomBuffer(const RandomBuffer&) = delete;
+        RandomBuffer& operator=(const RandomBuffer&) = delete;
+
+        bool Bytes(void* out, size_t len);
+        // Uniform in [0, bound) for bound > 0, by rejection sampling.
+        bool Uniform(uint32_t bound, uint32_t& out);
+
+    private:
+        bool Refill();
+
+        unsigned char buffer_[kBufferSize] = {};
+        size_t pos_ = kBufferSize;
+    };
+
+    // AES-256-GCM key object built once from raw key bytes. The key schedule
+    // lives in a locked, zeroed-on-release buffer; Encrypt/Decrypt work on
+    // caller-provided buffers and run concurrently from several threads,
+    // since a GCM call without chaining keeps no state in the handle. Only
+    // Import, Reset and Swap take the lock exclusively.
+    class Key {
+    public:
+        static const size_t kSize = 32;
+        static const size_t kNonceSize = 12;
+        static const size_t kTagSize = 16;
+
+        Key() = default;
+        ~Key();
+        Key(const Key&) = delete;
+        Key& operator=(const Key&) = delete;
+
+        bool Import(const unsigned char* key, size_t len);
+        void Reset();
+        void Swap(Key& other);
+        // Gives out its own handle on the same key.
+        bool Copy(Key& out) const;
+        bool Valid() const { return handle_ != nullptr; }
+
+        bool Encrypt(const unsigned char* nonce, const unsigned char* aad, size_t aadLen,
+            const unsigned char* in, size_t len, unsigned char* out, unsigned char* tag) const;
+        bool Decrypt(const unsigned char* nonce, const unsigned char* aad, size_t aadLen,
+            const unsigned char* in, size_t len, unsigned char* out, const unsigned char* tag) const;
+
+    private:
+        void* handle_ = nullptr;
+        std::vector<unsigned char> object_;
+        mutable std::shared_mutex lock_;
+    };
+
+    // Unlocked vault key. Derived once per unlock and held as a CNG key object,
+    // so each save only costs a fresh nonce and one AES-GCM pass. The session
+    // also holds the random records key that seals per-entry secrets; it is
+    // stored in the checkpoint wrapped under the vault key, so a password
+    // change or KDF upgrade only rewraps it.
+    class Session {
+    public:
+        Session() = default;
+        ~Session();
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+        bool Create(const std::wstring& password);
+        bool Open(const std::wstring& password, const unsigned char* blob, size_t size, std::vector<unsigned char>& plaintext);
+        bool Seal(const std::vector<unsigned char>& plaintext, Blob& out) const;
+        bool NeedsUpgrade() const;
+        // Derives a key for password with fresh KDF parameters into out,
+        // which keeps this session's records key. This session is unchanged
+        // until the caller swaps the two.
+        bool Rekey(const std::wstring& password, Session& out) const;
+        void Swap(Session& other);
+        // An independent session on the same keys, for worker threads that
+        // must not share this one's state.
+        bool Copy(Session& out) const;
+        bool NewRecordKey();
+        bool LoadRecordKey(const std::vector<unsigned char>& wrapped);
+        // Fills out with len bytes of HKDF-SHA256 output keyed from the
+        // records key, distinct for every label.
+        bool Subkey(const char* label, unsigned char* out, size_t len) const;
+        void Close();
+        bool IsOpen() const { return key_.Valid(); }
+        const KdfParams& Params() const { return params_; }
+        const Key& VaultKey() const { return key_; }
+        const Key& RecordKey() const { return records_; }
+        const std::vector<unsigned char>& WrappedRecordKey() const { return wrapped_; }
+
+    private:
+        bool Adopt(std::vector<unsigned char>& key, const KdfParams& params);
+        bool Wrap(const std::vector<unsigned char>& records);
+
+        KdfParams params_;
+        Key key_;
+        Key records_;
+        std::vector<unsigned char> wrapped_;
+    };
+
+    // Chunked AES-GCM for vault files. Plaintext is cut into fixed-size
+    // chunks, each sealed under nonce prefix || counter || final flag with
+    // the file header as associated data, so a chunk that is reordered,
+    // dropped or cut off fails to open. Memory stays bounded by one chunk
+    // however large the payload is.
+    class SealStream {
+    public:
+        static const size_t kChunkSize = 64 * 1024;
+        static const size_t kPrefixSize = 7;
+
+        SealStream() = default;
+        ~SealStream();
+        SealStream(const SealStream&) = delete;
+        SealStream& operator=(const SealStream&) = delete;
+
+        // Each call appends whatever header and sealed chunks are ready to out.
+        bool Begin(const Session& session, std::vector<unsigned char>& out);
+        bool Update(const unsigned char* in, size_t len, std::vector<unsigned char>& out);
+        bool Finish(std::vector<unsigned char>& out);
+        // Tag of the final chunk, valid after Finish.
+        const unsigned char* Tag() const { return tag_; }
+
+    private:
+        bool SealChunk(const unsigned char* in, size_t len, bool final, std::vector<unsigned char>& out);
+
+        const Key* key_ = nullptr;
+        std::vector<unsigned char> aad_;
+        unsigned char prefix_[kPrefixSize] = {};
+        unsigned long counter_ = 0;
+        std::vector<unsigned char> buffer_;
+        unsigned char tag_[Key::kTagSize] = {};
+    };
+
+    class OpenStream {
+    public:
+        OpenStream() = default;
+        ~OpenStream();
+        OpenStream(const OpenStream&) = delete;
+        OpenStream& operator=(const OpenStream&) = delete;
+
+        // Parses the header at the front of blob; headerLen receives its size.
+        // Ciphertext after it is then fed through Update in any amounts.
+        bool Begin(const Key& key, const unsigned char* blob, size_t size, size_t& headerLen);
+        bool Update(const unsigned char* in, size_t len, std::vector<unsigned char>& out);
+        bool Finish(std::vector<unsigned char>& out);
+
+    private:
+        bool OpenChunk(const unsigned char* in, size_t len, bool final, std::vector<unsigned char>& out);
+
+        const Key* key_ = nullptr;
+        std::vector<unsigned char> aad_;
+        unsigned char prefix_[SealStream::kPrefixSize] = {};
+        size_t chunkSize_ = 0;
+        unsigned long counter_ = 0;
+        std::vector<unsigned char> buffer_;
+    };
+
+    // GCM tag of a sealed blob; unique per Seal, so it identifies one checkpoint.
+    bool BlobTag(const unsigned char* blob, size_t size, unsigned char* tag);
     bool Encrypt(const std::wstring& password, const std::vector<unsigned char>& plaintext, Blob& out);
     bool Decrypt(const std::wstring& password, const std::vector<unsigned char>& blob, std::vector<unsigned char>& plaintext);
     void SecureZero(void* ptr, size_t len);
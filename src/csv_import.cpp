@@ -0,0 +1,462 @@
+#include "csv_import.h"
+#include "codec.h"
+#include "match.h"
+#include "parallel.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define LSK_SIMD 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+    const size_t kReadChunk = 1 << 20;
+    const size_t kMaxRecord = 1 << 20;
+    // A batch goes to the builders once it holds this many rows or bytes.
+    const size_t kBatchRows = 8192;
+    const size_t kBatchBytes = 4 << 20;
+    const size_t kBlock = 32;
+    // Row outcomes besides the csv::Problem values.
+    const uint8_t kBuilt = 0xFE;
+    const uint8_t kBlank = 0xFF;
+
+    enum Column { kTitle, kCategory, kUsername, kPassword, kUrl, kNotes, kColumns };
+
+    // Matched case-folded with surrounding spaces trimmed. Without a known
+    // name the columns are read in this order, which is the export's.
+    const wchar_t* const kAliases[kColumns][8] = {
+        { L"title", L"name", L"account", L"название", L"заголовок", nullptr },
+        { L"category", L"group", L"grouping", L"folder", L"категория", L"группа", L"папка", nullptr },
+        { L"username", L"user", L"login", L"login name", L"login_username", L"логин", L"имя пользователя", nullptr },
+        { L"password", L"login_password", L"пароль", nullptr },
+        { L"url", L"website", L"web site", L"login_uri", L"uri", L"адрес", L"сайт", nullptr },
+        { L"notes", L"note", L"extra", L"comments", L"заметки", L"примечания", nullptr },
+    };
+
+    struct Row {
+        uint32_t start = 0;
+        uint32_t firstField = 0;
+        uint32_t fields = 0;
+        uint64_t line = 0;
+    };
+
+    // Raw bytes of whole records and where each of their fields ends. The
+    // text is reserved once at its largest so plaintext is never left
+    // behind by a reallocation, and wiped before reuse.
+    struct Batch {
+        std::vector<unsigned char> text;
+        std::vector<uint32_t> ends;
+        std::vector<Row> rows;
+        // Leading rows that are not data: the header.
+        size_t skip = 0;
+
+        Batch() { text.reserve(kBatchBytes + kReadChunk); }
+        ~Batch() { Clear(); }
+
+        void Clear() {
+            crypto::SecureZero(text.data(), text.size());
+            text.clear();
+            ends.clear();
+            rows.clear();
+            skip = 0;
+        }
+
+        // Field f of the row as it appears in the file, quotes and all.
+        codec::Bytes Field(const Row& row, uint32_t f) const {
+            const size_t begin = f == 0 ? row.start : ends[row.firstField + f - 1] + 1;
+            return { text.data() + begin, ends[row.firstField + f] - begin };
+        }
+    };
+
+    struct Masks {
+        uint32_t quotes = 0;
+        uint32_t commas = 0;
+        uint32_t newlines = 0;
+    };
+
+    // Bit i of each mask marks p[i], for n bytes up to kBlock.
+    Masks ClassifyScalar(const unsigned char* p, size_t n) {
+        Masks m;
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t bit = 1u << i;
+            if (p[i] == '"') m.quotes |= bit;
+            else if (p[i] == ',') m.commas |= bit;
+            else if (p[i] == '\n') m.newlines |= bit;
+        }
+        return m;
+    }
+
+#ifdef LSK_SIMD
+    uint32_t Matches(__m128i lo, __m128i hi, char c) {
+        const __m128i v = _mm_set1_epi8(c);
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lo, v)) |
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(hi, v)) << 16;
+    }
+#endif
+
+    Masks Classify(const unsigned char* p) {
+#ifdef LSK_SIMD
+        const __m128i lo = _mm_loadu_si128((const __m128i*)p);
+        const __m128i hi = _mm_loadu_si128((const __m128i*)(p + 16));
+        Masks m;
+        m.quotes = Matches(lo, hi, '"');
+        m.commas = Matches(lo, hi, ',');
+        m.newlines = Matches(lo, hi, '\n');
+        return m;
+#else
+        return ClassifyScalar(p, kBlock);
+#endif
+    }
+
+    unsigned LowestBit(uint32_t bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctz(bits);
+#endif
+    }
+
+    unsigned PopCount(uint32_t bits) {
+        return (unsigned)std::bitset<32>(bits).count();
+    }
+
+    // Splits a batch's bytes into records as they arrive. Blocks are
+    // classified with SIMD and only their quotes, commas and newlines are
+    // visited. A quote opens a quoted field only as the field's first byte;
+    // anywhere else it is kept as text and the row is reported when its
+    // fields are unquoted, so one stray quote cannot swallow the lines
+    // after it.
+    class Scanner {
+    public:
+        void Skip(size_t n) { pos_ = recordStart_ = fieldStart_ = n; }
+
+        // Classifies the text from where the last call stopped to its end.
+        void Run(Batch& b) {
+            const unsigned char* text = b.text.data();
+            const size_t size = b.text.size();
+            while (pos_ < size) {
+                const size_t n = std::min(kBlock, size - pos_);
+                const Masks m = n == kBlock ? Classify(text + pos_) : ClassifyScalar(text + pos_, n);
+                uint32_t special = m.quotes | m.commas | m.newlines;
+                while (special) {
+                    const unsigned j = LowestBit(special);
+                    const uint32_t bit = 1u << j;
+                    const size_t at = pos_ + j;
+                    special &= special - 1;
+                    if (m.quotes & bit) {
+                        if (state_ == kQuoted) {
+                            state_ = kClosing;
+                            quoteAt_ = at;
+                        } else if (state_ == kClosing) {
+                            // A doubled quote, or text after the closing one.
+                            state_ = at == quoteAt_ + 1 ? kQuoted : kPlain;
+                        } else if (at == fieldStart_) {
+                            state_ = kQuoted;
+                        }
+                        continue;
+                    }
+                    if (state_ == kQuoted) continue;
+                    state_ = kPlain;
+                    if (m.newlines & bit) {
+                        EndRecord(b, at, newlines_ + PopCount(m.newlines & ((2u << j) - 1)) + 1);
+                    } else {
+                        b.ends.push_back((uint32_t)at);
+                    }
+                    fieldStart_ = at + 1;
+                }
+                newlines_ += PopCount(m.newlines);
+                pos_ += n;
+            }
+        }
+
+        // Ends a last record that has no newline. False if it is still
+        // inside a quoted field.
+        bool Finish(Batch& b) {
+            if (recordStart_ >= b.text.size()) return true;
+            if (state_ == kQuoted) return false;
+            EndRecord(b, b.text.size(), recordLine_);
+            recordStart_ = b.text.size();
+            return true;
+        }
+
+        // Moves the unfinished record at the end of from to the front of to.
+        void Carry(Batch& from, Batch& to) {
+            to.Clear();
+            to.text.insert(to.text.end(), from.text.begin() + recordStart_, from.text.end());
+            const size_t first = FirstField(from);
+            for (size_t f = first; f < from.ends.size(); ++f) to.ends.push_back(from.ends[f] - (uint32_t)recordStart_);
+            from.ends.resize(first);
+            crypto::SecureZero(from.text.data() + recordStart_, from.text.size() - recordStart_);
+            from.text.resize(recordStart_);
+            pos_ -= recordStart_;
+            fieldStart_ -= recordStart_;
+            if (state_ == kClosing) quoteAt_ -= recordStart_;
+            recordStart_ = 0;
+        }
+
+        size_t Pending(const Batch& b) const { return b.text.size() - recordStart_; }
+        uint64_t RecordLine() const { return recordLine_; }
+
+    private:
+        static size_t FirstField(const Batch& b) {
+            return b.rows.empty() ? 0 : b.rows.back().firstField + b.rows.back().fields;
+        }
+
+        void EndRecord(Batch& b, size_t at, uint64_t nextLine) {
+            size_t end = at;
+            if (end > recordStart_ && b.text[end - 1] == '\r') --end;
+            Row row;
+            row.start = (uint32_t)recordStart_;
+            row.firstField = (uint32_t)FirstField(b);
+            b.ends.push_back((uint32_t)end);
+            row.fields = (uint32_t)(b.ends.size() - row.firstField);
+            row.line = recordLine_;
+            b.rows.push_back(row);
+            recordStart_ = at + 1;
+            recordLine_ = nextLine;
+        }
+
+        enum State {
+            kPlain,
+            kQuoted,
+            // Just past a quote inside a quoted field, at quoteAt_.
+            kClosing
+        };
+
+        size_t pos_ = 0;
+        size_t recordStart_ = 0;
+        size_t fieldStart_ = 0;
+        size_t quoteAt_ = 0;
+        uint64_t recordLine_ = 1;
+        // Newlines before pos_, quoted or not.
+        uint64_t newlines_ = 0;
+        State state_ = kPlain;
+    };
+
+    // The field with its quotes removed. Unquoted fields are used in place;
+    // quoted ones are copied into scratch with doubled quotes collapsed.
+    // False for a quote anywhere else.
+    bool Unquote(codec::Bytes raw, std::vector<unsigned char>& scratch, codec::Bytes& out) {
+        if (raw.size == 0 || raw.data[0] != '"') {
+            if (memchr(raw.data, '"', raw.size)) return false;
+            out = raw;
+            return true;
+        }
+        if (raw.size < 2 || raw.data[raw.size - 1] != '"') return false;
+        scratch.clear();
+        for (size_t i = 1; i + 1 < raw.size; ++i) {
+            if (raw.data[i] == '"') {
+                if (i + 2 >= raw.size || raw.data[i + 1] != '"') return false;
+                ++i;
+            }
+            scratch.push_back(raw.data[i]);
+        }
+        out = { scratch.data(), scratch.size() };
+        return true;
+    }
+
+    struct Columns {
+        int index[kColumns] = {};
+        uint32_t count = 0;
+    };
+
+    bool IsAlias(const std::wstring& name, int column) {
+        for (const wchar_t* const* a = kAliases[column]; *a; ++a) {
+            if (name == *a) return true;
+        }
+        return false;
+    }
+
+    bool IsBlank(const Batch& b, const Row& row) {
+        return row.fields == 1 && b.ends[row.firstField] == row.start;
+    }
+
+    // Maps columns from the first non-blank row if it names any of them;
+    // otherwise that row is data in export order.
+    bool ReadHeader(const Batch& b, const Row& row, Columns& out) {
+        out.count = row.fields;
+        for (int c = 0; c < kColumns; ++c) out.index[c] = -1;
+        std::vector<unsigned char> scratch;
+        bool found = false;
+        for (uint32_t f = 0; f < row.fields; ++f) {
+            codec::Bytes bytes;
+            if (!Unquote(b.Field(row, f), scratch, bytes)) continue;
+            std::wstring name;
+            codec::DecodeUtf8(bytes, name);
+            const size_t first = name.find_first_not_of(L" \t");
+            name = first == std::wstring::npos ? L"" : name.substr(first, name.find_last_not_of(L" \t") - first + 1);
+            for (auto& ch : name) ch = search::Fold(ch);
+            for (int c = 0; c < kColumns; ++c) {
+                if (out.index[c] < 0 && IsAlias(name, c)) {
+                    out.index[c] = (int)f;
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found) {
+            for (int c = 0; c < kColumns; ++c) out.index[c] = c < (int)row.fields ? c : -1;
+        }
+        return found;
+    }
+
+    uint8_t BuildRow(const crypto::Session& session, const Columns& columns, const Batch& b, const Row& row,
+        uint64_t id, std::vector<unsigned char>& scratch, Entry& e) {
+        if (IsBlank(b, row)) return kBlank;
+        if (row.fields != columns.count) return csv::kFieldCount;
+        Secrets secrets;
+        std::wstring* const targets[kColumns] = {
+            &e.title, &e.category, &e.username, &secrets.password, &e.url, &secrets.notes
+        };
+        for (int c = 0; c < kColumns; ++c) {
+            if (columns.index[c] < 0) continue;
+            codec::Bytes bytes;
+            const bool ok = Unquote(b.Field(row, (uint32_t)columns.index[c]), scratch, bytes);
+            if (ok) codec::DecodeUtf8(bytes, *targets[c]);
+            crypto::SecureZero(scratch.data(), scratch.size());
+            if (!ok) return csv::kQuotes;
+        }
+        e.id = id;
+        return vault::SealSecrets(session, e, secrets) ? kBuilt : csv::kSealFailed;
+    }
+
+    // Row r of the batch gets id firstId + r whether or not it is built.
+    struct Built {
+        std::vector<Entry> entries;
+        std::vector<uint8_t> status;
+    };
+
+    void BuildBatch(const crypto::Session& session, const Columns& columns, const Batch& b, uint64_t firstId,
+        Built& out) {
+        const size_t n = b.rows.size();
+        out.entries.assign(n, Entry());
+        out.status.assign(n, kBlank);
+        parallel::ForBlocks(n, parallel::kMinSecretsPerThread, [&](size_t begin, size_t end) {
+            // Sized for the longest record so it never reallocates.
+            std::vector<unsigned char> scratch;
+            scratch.reserve(kMaxRecord);
+            for (size_t r = std::max(begin, b.skip); r < end; ++r) {
+                out.status[r] = BuildRow(session, columns, b, b.rows[r], firstId + r, scratch, out.entries[r]);
+            }
+        });
+    }
+
+    void AddBad(csv::Report& out, uint64_t line, csv::Problem problem) {
+        ++out.badCount;
+        if (out.bad.size() < csv::kMaxReported) out.bad.push_back({ line, problem });
+    }
+
+    void Collect(const Batch& b, Built& built, Vault& v, csv::Report& out) {
+        for (size_t r = 0; r < b.rows.size(); ++r) {
+            const uint8_t status = built.status[r];
+            if (status == kBuilt) {
+                v.entries.Append(built.entries[r]);
+                ++out.imported;
+            } else if (status != kBlank) {
+                AddBad(out, b.rows[r].line, (csv::Problem)status);
+            }
+        }
+        built.entries.clear();
+    }
+}
+
+namespace csv {
+    bool Import(const crypto::Session& session, const std::wstring& path, Vault& v, Report& out) {
+        out = Report();
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        std::unique_ptr<Batch> parsing(new Batch);
+        std::unique_ptr<Batch> building(new Batch);
+        Scanner scanner;
+        Columns columns;
+        bool haveColumns = false;
+        Built built;
+        std::thread worker;
+
+        // Waits for the batch being built and appends its rows in order.
+        auto collect = [&]() {
+            if (!worker.joinable()) return;
+            worker.join();
+            Collect(*building, built, v, out);
+        };
+        // Starts building the records parsed so far; the unfinished one
+        // stays behind to be completed by the next read.
+        auto handOff = [&]() {
+            collect();
+            scanner.Carry(*parsing, *building);
+            std::swap(parsing, building);
+            if (building->rows.empty()) return;
+            if (!haveColumns) {
+                // Leading blank lines must not fix the column count; a batch
+                // of nothing else leaves it to the next one.
+                size_t r = 0;
+                while (r < building->rows.size() && IsBlank(*building, building->rows[r])) ++r;
+                if (r < building->rows.size()) {
+                    out.header = ReadHeader(*building, building->rows[r], columns);
+                    building->skip = r + (out.header ? 1 : 0);
+                    haveColumns = true;
+                }
+            }
+            const uint64_t firstId = v.nextId;
+            v.nextId += building->rows.size();
+            const Batch* batch = building.get();
+            worker = std::thread([&session, &columns, &built, batch, firstId]() {
+                BuildBatch(session, columns, *batch, firstId, built);
+            });
+        };
+
+        bool ok = true;
+        bool first = true;
+        for (;;) {
+            Batch& b = *parsing;
+            const size_t base = b.text.size();
+            b.text.resize(base + kReadChunk);
+            DWORD got = 0;
+            if (!ReadFile(file, b.text.data() + base, (DWORD)kReadChunk, &got, nullptr)) {
+                got = 0;
+                ok = false;
+            }
+            b.text.resize(base + got);
+            if (got == 0) break;
+            if (first) {
+                first = false;
+                if (got >= 3 && memcmp(b.text.data(), "\xEF\xBB\xBF", 3) == 0) scanner.Skip(3);
+            }
+            scanner.Run(b);
+            if (scanner.Pending(b) > kMaxRecord) {
+                AddBad(out, scanner.RecordLine(), kTooLong);
+                ok = false;
+                break;
+            }
+            if (b.rows.size() >= kBatchRows || b.text.size() >= kBatchBytes) handOff();
+        }
+        CloseHandle(file);
+        if (ok && !scanner.Finish(*parsing)) AddBad(out, scanner.RecordLine(), kQuotes);
+        handOff();
+        collect();
+        return ok;
+    }
+
+    const wchar_t* Describe(Problem problem) {
+        switch (problem) {
+        case kFieldCount: return L"неверное число полей";
+        case kQuotes: return L"ошибка в кавычках";
+        case kTooLong: return L"слишком длинная запись";
+        case kSealFailed: return L"не удалось зашифровать";
+        }
+        return L"";
+    }
+}
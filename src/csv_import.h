@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crypto.h"
+#include "vault.h"
+
+// RFC 4180 import. The file is read as raw UTF-8 a block at a time; quoted
+// fields may hold delimiters, doubled quotes and line breaks. Columns are
+// taken from the header row when it names any known field (our own export,
+// browsers and the common managers, in English or Russian), otherwise the
+// file is read in export order with no header. Memory stays bounded by two
+// batches of rows however large the file is.
+namespace csv {
+    const size_t kMaxReported = 100;
+
+    enum Problem {
+        kFieldCount,
+        kQuotes,
+        kTooLong,
+        kSealFailed
+    };
+
+    struct BadRow {
+        // Line the row starts on, counting from 1.
+        uint64_t line = 0;
+        Problem problem = kFieldCount;
+    };
+
+    struct Report {
+        size_t imported = 0;
+        // The first kMaxReported bad rows; badCount counts them all.
+        std::vector<BadRow> bad;
+        size_t badCount = 0;
+        bool header = false;
+    };
+
+    // Appends every good row to v in file order with fresh ids, sealing
+    // secrets under the session. Rows are split into records on this thread
+    // while the previous batch is decoded and sealed across the others.
+    // Blank lines are skipped; other rows that cannot be read are reported
+    // and skipped. False if the file cannot be read or a record runs past
+    // the size limit, which is reported as kTooLong; rows before it stay
+    // imported.
+    bool Import(const crypto::Session& session, const std::wstring& path, Vault& v, Report& out);
+
+    const wchar_t* Describe(Problem problem);
+}
@@ -0,0 +1,239 @@
+#include "entries.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Compaction waits for at least this much garbage, and for garbage to
+    // be half the arenas, so its cost stays proportional to the edits.
+    const size_t kMinGarbage = 64 * 1024;
+    const size_t kOutside = (size_t)-1;
+
+    // Grows v geometrically so that extra more elements fit.
+    template <typename T>
+    void Grow(std::vector<T>& v, size_t extra) {
+        if (v.capacity() - v.size() >= extra) return;
+        v.reserve(std::max(v.size() + extra, v.capacity() + v.capacity() / 2));
+    }
+}
+
+EntryRef EntryTable::operator[](size_t pos) const {
+    const Record& r = records_[pos];
+    auto text = [&](int field) {
+        const Span& s = r.text[field];
+        return s.size == 0 ? std::wstring_view(L"", 0) : std::wstring_view(text_.data() + s.offset, s.size);
+    };
+    EntryRef e;
+    e.id = r.id;
+    e.title = text(0);
+    e.category = text(1);
+    e.username = text(2);
+    e.url = text(3);
+    e.secrets.data = bytes_.data() + r.secrets.offset;
+    e.secrets.size = r.secrets.size;
+    if (r.attachments != kNoAttachments) e.attachments = attachments_[r.attachments];
+    return e;
+}
+
+void EntryTable::Reserve(size_t count, size_t chars, size_t bytes) {
+    records_.reserve(records_.size() + count);
+    text_.reserve(text_.size() + chars + count * kTextFields);
+    bytes_.reserve(bytes_.size() + bytes);
+}
+
+void EntryTable::Append(const EntryRef& e) {
+    Record r;
+    Fill(r, e);
+    records_.push_back(r);
+}
+
+// The new fields are stored before the old ones are released, so e may be
+// a view of the very entry it replaces.
+void EntryTable::Replace(size_t pos, const EntryRef& e) {
+    Record r;
+    Fill(r, e);
+    Release(records_[pos]);
+    records_[pos] = r;
+    MaybeCompact();
+}
+
+void EntryTable::Erase(size_t pos) {
+    Release(records_[pos]);
+    records_.erase(records_.begin() + pos);
+    MaybeCompact();
+}
+
+void EntryTable::Erase(const std::vector<bool>& marked) {
+    size_t out = 0;
+    for (size_t i = 0; i < records_.size(); ++i) {
+        if (i < marked.size() && marked[i]) {
+            Release(records_[i]);
+            continue;
+        }
+        records_[out++] = records_[i];
+    }
+    records_.resize(out);
+    MaybeCompact();
+}
+
+void EntryTable::Load(size_t pos, Entry& out) const {
+    const EntryRef e = (*this)[pos];
+    out.id = e.id;
+    out.title.assign(e.title);
+    out.category.assign(e.category);
+    out.username.assign(e.username);
+    out.url.assign(e.url);
+    out.secrets.assign(e.secrets.data, e.secrets.data + e.secrets.size);
+    out.attachments.assign(e.attachments.begin(), e.attachments.end());
+}
+
+void EntryTable::Clear() {
+    records_.clear();
+    text_.clear();
+    bytes_.clear();
+    attachments_.clear();
+    freeAttachments_.clear();
+    garbage_ = 0;
+}
+
+void EntryTable::Compact() {
+    size_t chars = 0;
+    size_t sealed = 0;
+    for (const auto& r : records_) {
+        for (const auto& s : r.text) chars += s.size == 0 ? 0 : s.size + 1;
+        sealed += r.secrets.size;
+    }
+    std::vector<wchar_t> text;
+    std::vector<unsigned char> bytes;
+    text.reserve(chars);
+    bytes.reserve(sealed);
+    for (auto& r : records_) {
+        for (auto& s : r.text) {
+            if (s.size == 0) continue;
+            const uint32_t offset = (uint32_t)text.size();
+            text.insert(text.end(), text_.data() + s.offset, text_.data() + s.offset + s.size + 1);
+            s.offset = offset;
+        }
+        const uint32_t offset = (uint32_t)bytes.size();
+        bytes.insert(bytes.end(), bytes_.data() + r.secrets.offset, bytes_.data() + r.secrets.offset + r.secrets.size);
+        r.secrets.offset = offset;
+    }
+    text_.swap(text);
+    bytes_.swap(bytes);
+    garbage_ = 0;
+}
+
+// The caller has already made room, so s stays valid even if it points
+// into text_.
+EntryTable::Span EntryTable::StoreText(const wchar_t* s, size_t len) {
+    Span span;
+    if (len == 0) return span;
+    span.offset = (uint32_t)text_.size();
+    span.size = (uint32_t)len;
+    text_.insert(text_.end(), s, s + len);
+    text_.push_back(L'\0');
+    return span;
+}
+
+EntryTable::Span EntryTable::StoreBytes(ByteSpan b) {
+    Span span;
+    if (b.size == 0) return span;
+    const bool inside = b.data >= bytes_.data() && b.data < bytes_.data() + bytes_.size();
+    const size_t from = inside ? (size_t)(b.data - bytes_.data()) : 0;
+    Grow(bytes_, b.size);
+    const unsigned char* src = inside ? bytes_.data() + from : b.data;
+    span.offset = (uint32_t)bytes_.size();
+    span.size = (uint32_t)b.size;
+    bytes_.resize(bytes_.size() + b.size);
+    memcpy(bytes_.data() + span.offset, src, b.size);
+    return span;
+}
+
+// e may view this table, so fields inside text_ are turned into offsets
+// before it grows, and it grows once for all of them.
+void EntryTable::Fill(Record& r, const EntryRef& e) {
+    const std::wstring_view fields[kTextFields] = { e.title, e.category, e.username, e.url };
+    const wchar_t* base = text_.data();
+    size_t from[kTextFields];
+    size_t need = 0;
+    for (int f = 0; f < kTextFields; ++f) {
+        const wchar_t* p = fields[f].data();
+        from[f] = !fields[f].empty() && p >= base && p < base + text_.size() ? (size_t)(p - base) : kOutside;
+        if (!fields[f].empty()) need += fields[f].size() + 1;
+    }
+    Grow(text_, need);
+    r.id = e.id;
+    for (int f = 0; f < kTextFields; ++f) {
+        const wchar_t* p = from[f] == kOutside ? fields[f].data() : text_.data() + from[f];
+        r.text[f] = StoreText(p, fields[f].size());
+    }
+    r.secrets = StoreBytes(e.secrets);
+    r.attachments = AcquireAttachments(e.attachments);
+}
+
+void EntryTable::Release(const Record& r) {
+    for (const auto& s : r.text) {
+        if (s.size != 0) garbage_ += (s.size + 1) * sizeof(wchar_t);
+    }
+    garbage_ += r.secrets.size;
+    if (r.attachments != kNoAttachments) {
+        std::vector<Attachment>().swap(attachments_[r.attachments]);
+        freeAttachments_.push_back(r.attachments);
+    }
+}
+
+uint32_t EntryTable::AcquireAttachments(const AttachmentSpan& list) {
+    if (list.empty()) return kNoAttachments;
+    uint32_t slot;
+    if (!freeAttachments_.empty()) {
+        slot = freeAttachments_.back();
+        freeAttachments_.pop_back();
+    } else {
+        slot = (uint32_t)attachments_.size();
+        attachments_.emplace_back();
+    }
+    attachments_[slot].assign(list.begin(), list.end());
+    return slot;
+}
+
+void EntryTable::MaybeCompact() {
+    const size_t total = text_.size() * sizeof(wchar_t) + bytes_.size();
+    if (garbage_ >= kMinGarbage && garbage_ * 2 >= total) Compact();
+}
+
+// Sized in one pass and filled in a second, so each column is allocated
+// once.
+void EntryColumns::Build(const EntryTable& table) {
+    const size_t n = table.Size();
+    size_t chars[kTextFields] = {};
+    size_t bytes = 0;
+    for (const EntryRef e : table) {
+        chars[kTitle] += e.title.size();
+        chars[kCategory] += e.category.size();
+        chars[kUsername] += e.username.size();
+        chars[kUrl] += e.url.size();
+        bytes += e.secrets.size;
+    }
+    ids_.clear();
+    ids_.reserve(n);
+    for (int f = 0; f < kTextFields; ++f) {
+        text_[f].offsets.assign(1, 0);
+        text_[f].offsets.reserve(n + 1);
+        text_[f].data.clear();
+        text_[f].data.reserve(chars[f]);
+    }
+    secrets_.offsets.assign(1, 0);
+    secrets_.offsets.reserve(n + 1);
+    secrets_.data.clear();
+    secrets_.data.reserve(bytes);
+    for (const EntryRef e : table) {
+        const std::wstring_view fields[kTextFields] = { e.title, e.category, e.username, e.url };
+        ids_.push_back(e.id);
+        for (int f = 0; f < kTextFields; ++f) {
+            text_[f].data.insert(text_[f].data.end(), fields[f].begin(), fields[f].end());
+            text_[f].offsets.push_back((uint32_t)text_[f].data.size());
+        }
+        secrets_.data.insert(secrets_.data.end(), e.secrets.data, e.secrets.data + e.secrets.size);
+        secrets_.offsets.push_back((uint32_t)secrets_.data.size());
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One stored chunk of an attachment, named by a keyed hash of its contents.
+struct ChunkRef {
+    unsigned char id[32] = {};
+    uint32_t size = 0;
+};
+
+// Attachment contents live outside the checkpoint as chunk objects; entries
+// only carry the references.
+struct Attachment {
+    std::wstring name;
+    uint64_t size = 0;
+    std::vector<ChunkRef> chunks;
+};
+
+// Index fields stay in the clear once the vault is unlocked; password and
+// notes live in secrets, sealed per entry under the session's records key.
+// An Entry is the editable form; the vault stores entries in an EntryTable.
+struct Entry {
+    uint64_t id = 0;
+    std::wstring title;
+    std::wstring category;
+    std::wstring username;
+    std::wstring url;
+    std::vector<unsigned char> secrets;
+    std::vector<Attachment> attachments;
+};
+
+struct ByteSpan {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+struct AttachmentSpan {
+    const Attachment* data = nullptr;
+    size_t count = 0;
+
+    AttachmentSpan() = default;
+    AttachmentSpan(const std::vector<Attachment>& list) : data(list.data()), count(list.size()) {}
+
+    const Attachment* begin() const { return data; }
+    const Attachment* end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Attachment& operator[](size_t i) const { return data[i]; }
+};
+
+// A read-only view of one entry, either in an EntryTable or in an Entry.
+// The text fields are null-terminated, so data() can go straight to Win32.
+// Views into a table are valid until the table next changes.
+struct EntryRef {
+    uint64_t id = 0;
+    std::wstring_view title;
+    std::wstring_view category;
+    std::wstring_view username;
+    std::wstring_view url;
+    ByteSpan secrets;
+    AttachmentSpan attachments;
+
+    EntryRef() = default;
+    EntryRef(const Entry& e)
+        : id(e.id), title(e.title), category(e.category), username(e.username), url(e.url),
+          secrets{ e.secrets.data(), e.secrets.size() }, attachments(e.attachments) {}
+};
+
+// Entries as fixed-size records of offsets into two append-only arenas, one
+// for text and one for sealed secrets, instead of six heap blocks each.
+// Stored strings never change: replacing an entry appends its new fields
+// and leaves the old ones as garbage until enough accumulates to compact.
+// Attachments are rare and stay in a side table.
+class EntryTable {
+public:
+    class Iterator {
+    public:
+        Iterator(const EntryTable* table, size_t pos) : table_(table), pos_(pos) {}
+        EntryRef operator*() const { return (*table_)[pos_]; }
+        Iterator& operator++() { ++pos_; return *this; }
+        bool operator!=(const Iterator& other) const { return pos_ != other.pos_; }
+
+    private:
+        const EntryTable* table_;
+        size_t pos_;
+    };
+
+    size_t Size() const { return records_.size(); }
+    bool Empty() const { return records_.empty(); }
+    EntryRef operator[](size_t pos) const;
+    uint64_t Id(size_t pos) const { return records_[pos].id; }
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, records_.size()); }
+
+    // Room for count more entries holding up to chars text units and bytes
+    // of secrets between them.
+    void Reserve(size_t count, size_t chars, size_t bytes);
+    void Append(const EntryRef& e);
+    void Replace(size_t pos, const EntryRef& e);
+    void Erase(size_t pos);
+    // Erases every position marked, keeping the others in order.
+    void Erase(const std::vector<bool>& marked);
+    void SetId(size_t pos, uint64_t id) { records_[pos].id = id; }
+    void Load(size_t pos, Entry& out) const;
+    void Clear();
+    // Copies the live fields into fresh arenas, dropping the garbage.
+    void Compact();
+
+private:
+    static const uint32_t kNoAttachments = 0xFFFFFFFF;
+    static const int kTextFields = 4;
+
+    struct Span {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct Record {
+        uint64_t id = 0;
+        Span text[kTextFields];
+        Span secrets;
+        uint32_t attachments = kNoAttachments;
+    };
+
+    Span StoreText(const wchar_t* s, size_t len);
+    Span StoreBytes(ByteSpan b);
+    void Fill(Record& r, const EntryRef& e);
+    void Release(const Record& r);
+    uint32_t AcquireAttachments(const AttachmentSpan& list);
+    void MaybeCompact();
+
+    std::vector<Record> records_;
+    std::vector<wchar_t> text_;
+    std::vector<unsigned char> bytes_;
+    std::vector<std::vector<Attachment>> attachments_;
+    std::vector<uint32_t> freeAttachments_;
+    // Arena bytes no record points to any more.
+    size_t garbage_ = 0;
+};
+
+// An optional column-by-column copy of an EntryTable, for scans that read
+// one field of every entry: an id column, and for each text field and the
+// sealed secrets an offsets array over one contiguous buffer. A scan then
+// streams only the columns it reads. It is a snapshot, built when a scan
+// wants it and never edited, so threads can split a column between them.
+// Its text is not null-terminated.
+class EntryColumns {
+public:
+    enum TextField { kTitle, kCategory, kUsername, kUrl, kTextFields };
+
+    void Build(const EntryTable& table);
+
+    size_t Size() const { return ids_.size(); }
+    uint64_t Id(size_t pos) const { return ids_[pos]; }
+    std::wstring_view Text(TextField field, size_t pos) const {
+        const Column<wchar_t>& c = text_[field];
+        return std::wstring_view(c.data.data() + c.offsets[pos], c.offsets[pos + 1] - c.offsets[pos]);
+    }
+    ByteSpan Secrets(size_t pos) const {
+        return ByteSpan{ secrets_.data.data() + secrets_.offsets[pos], secrets_.offsets[pos + 1] - secrets_.offsets[pos] };
+    }
+
+private:
+    // Entry pos spans [offsets[pos], offsets[pos + 1]) of data.
+    template <typename Unit>
+    struct Column {
+        std::vector<uint32_t> offsets;
+        std::vector<Unit> data;
+    };
+
+    std::vector<uint64_t> ids_;
+    Column<wchar_t> text_[kTextFields];
+    Column<unsigned char> secrets_;
+};
@@ -0,0 +1,428 @@
+#include "kdf.h"
+#include "crypto.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+    const uint32_t kVersion = 0x13;
+    const uint32_t kTypeId = 2;
+    const uint32_t kSyncPoints = 4;
+    const uint32_t kBlockWords = 128;
+    const uint32_t kAddressesInBlock = 128;
+    const uint32_t kMinMemoryKiB = 19 * 1024;
+    const uint32_t kProbeMemoryKiB = 16 * 1024;
+
+    struct Block {
+        uint64_t v[kBlockWords];
+    };
+
+    // BLAKE2b, as much of it as Argon2 needs: keyless, arbitrary digest length
+    // up to 64 bytes, input fed incrementally.
+    const uint64_t kBlakeIv[8] = {
+        0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+    };
+
+    const uint8_t kSigma[12][16] = {
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+        { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+        { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+        { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+        { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+        { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+        { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+        { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+        { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+    };
+
+    inline uint64_t Rotr64(uint64_t x, unsigned n) {
+        return (x >> n) | (x << (64 - n));
+    }
+
+    inline uint64_t Load64(const unsigned char* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+        return v;
+    }
+
+    inline void Store64(unsigned char* p, uint64_t v) {
+        for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+    }
+
+    inline void Store32(unsigned char* p, uint32_t v) {
+        for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+    }
+
+    class Blake2b {
+    public:
+        explicit Blake2b(size_t outLen) : outLen_(outLen) {
+            memcpy(h_, kBlakeIv, sizeof(h_));
+            h_[0] ^= 0x01010000ULL ^ (uint64_t)outLen;
+        }
+
+        void Update(const void* data, size_t len) {
+            const unsigned char* in = (const unsigned char*)data;
+            while (len > 0) {
+                if (bufLen_ == sizeof(buf_)) {
+                    counter_ += sizeof(buf_);
+                    Compress(false);
+                    bufLen_ = 0;
+                }
+                size_t take = std::min(len, sizeof(buf_) - bufLen_);
+                memcpy(buf_ + bufLen_, in, take);
+                bufLen_ += take;
+                in += take;
+                len -= take;
+            }
+        }
+
+        void UpdateU32(uint32_t v) {
+            unsigned char b[4];
+            Store32(b, v);
+            Update(b, sizeof(b));
+        }
+
+        void Final(unsigned char* out) {
+            counter_ += bufLen_;
+            memset(buf_ + bufLen_, 0, sizeof(buf_) - bufLen_);
+            Compress(true);
+            unsigned char full[64];
+            for (int i = 0; i < 8; ++i) Store64(full + 8 * i, h_[i]);
+            memcpy(out, full, outLen_);
+            crypto::SecureZero(full, sizeof(full));
+            crypto::SecureZero(buf_, sizeof(buf_));
+        }
+
+    private:
+        void Compress(bool last) {
+            uint64_t m[16];
+            uint64_t v[16];
+            for (int i = 0; i < 16; ++i) m[i] = Load64(buf_ + 8 * i);
+            for (int i = 0; i < 8; ++i) {
+                v[i] = h_[i];
+                v[i + 8] = kBlakeIv[i];
+            }
+            v[12] ^= (uint64_t)counter_;
+            if (last) v[14] = ~v[14];
+
+            auto g = [&](int r, int i, uint64_t& a, uint64_t& b, uint64_t& c, uint64_t& d) {
+                a = a + b + m[kSigma[r][2 * i]];
+                d = Rotr64(d ^ a, 32);
+                c = c + d;
+                b = Rotr64(b ^ c, 24);
+                a = a + b + m[kSigma[r][2 * i + 1]];
+                d = Rotr64(d ^ a, 16);
+                c = c + d;
+                b = Rotr64(b ^ c, 63);
+            };
+            for (int r = 0; r < 12; ++r) {
+                g(r, 0, v[0], v[4], v[8], v[12]);
+                g(r, 1, v[1], v[5], v[9], v[13]);
+                g(r, 2, v[2], v[6], v[10], v[14]);
+                g(r, 3, v[3], v[7], v[11], v[15]);
+                g(r, 4, v[0], v[5], v[10], v[15]);
+                g(r, 5, v[1], v[6], v[11], v[12]);
+                g(r, 6, v[2], v[7], v[8], v[13]);
+                g(r, 7, v[3], v[4], v[9], v[14]);
+            }
+            for (int i = 0; i < 8; ++i) h_[i] ^= v[i] ^ v[i + 8];
+        }
+
+        uint64_t h_[8];
+        unsigned char buf_[128] = {};
+        size_t bufLen_ = 0;
+        uint64_t counter_ = 0;
+        size_t outLen_;
+    };
+
+    // H' from RFC 9106 section 3.3: BLAKE2b stretched to an arbitrary length.
+    void HashLong(unsigned char* out, size_t outLen, const void* in, size_t inLen) {
+        if (outLen <= 64) {
+            Blake2b h(outLen);
+            h.UpdateU32((uint32_t)outLen);
+            h.Update(in, inLen);
+            h.Final(out);
+            return;
+        }
+        unsigned char v[64];
+        Blake2b h(64);
+        h.UpdateU32((uint32_t)outLen);
+        h.Update(in, inLen);
+        h.Final(v);
+        memcpy(out, v, 32);
+        out += 32;
+        size_t remaining = outLen - 32;
+        while (remaining > 64) {
+            Blake2b next(64);
+            next.Update(v, 64);
+            next.Final(v);
+            memcpy(out, v, 32);
+            out += 32;
+            remaining -= 32;
+        }
+        Blake2b last(remaining);
+        last.Update(v, 64);
+        last.Final(out);
+        crypto::SecureZero(v, sizeof(v));
+    }
+
+    inline uint64_t BlaMka(uint64_t x, uint64_t y) {
+        const uint64_t m = 0xFFFFFFFFULL;
+        return x + y + 2 * ((x & m) * (y & m));
+    }
+
+    inline void Gb(uint64_t& a, uint64_t& b, uint64_t& c, uint64_t& d) {
+        a = BlaMka(a, b);
+        d = Rotr64(d ^ a, 32);
+        c = BlaMka(c, d);
+        b = Rotr64(b ^ c, 24);
+        a = BlaMka(a, b);
+        d = Rotr64(d ^ a, 16);
+        c = BlaMka(c, d);
+        b = Rotr64(b ^ c, 63);
+    }
+
+    inline void Round(uint64_t* v, int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7,
+        int s8, int s9, int s10, int s11, int s12, int s13, int s14, int s15) {
+        Gb(v[s0], v[s4], v[s8], v[s12]);
+        Gb(v[s1], v[s5], v[s9], v[s13]);
+        Gb(v[s2], v[s6], v[s10], v[s14]);
+        Gb(v[s3], v[s7], v[s11], v[s15]);
+        Gb(v[s0], v[s5], v[s10], v[s15]);
+        Gb(v[s1], v[s6], v[s11], v[s12]);
+        Gb(v[s2], v[s7], v[s8], v[s13]);
+        Gb(v[s3], v[s4], v[s9], v[s14]);
+    }
+
+    // Compression function G. With xorInto set the result is XORed over the
+    // existing contents of next, as version 0x13 requires after the first pass.
+    void FillBlock(const Block& prev, const Block& ref, Block& next, bool xorInto) {
+        Block r;
+        Block tmp;
+        for (uint32_t i = 0; i < kBlockWords; ++i) r.v[i] = prev.v[i] ^ ref.v[i];
+        tmp = r;
+        if (xorInto) {
+            for (uint32_t i = 0; i < kBlockWords; ++i) tmp.v[i] ^= next.v[i];
+        }
+        for (int i = 0; i < 8; ++i) {
+            const int b = 16 * i;
+            Round(r.v, b, b + 1, b + 2, b + 3, b + 4, b + 5, b + 6, b + 7,
+                b + 8, b + 9, b + 10, b + 11, b + 12, b + 13, b + 14, b + 15);
+        }
+        for (int i = 0; i < 8; ++i) {
+            const int b = 2 * i;
+            Round(r.v, b, b + 1, b + 16, b + 17, b + 32, b + 33, b + 48, b + 49,
+                b + 64, b + 65, b + 80, b + 81, b + 96, b + 97, b + 112, b + 113);
+        }
+        for (uint32_t i = 0; i < kBlockWords; ++i) next.v[i] = tmp.v[i] ^ r.v[i];
+    }
+
+    struct Instance {
+        Block* memory = nullptr;
+        uint32_t passes = 0;
+        uint32_t lanes = 0;
+        uint32_t laneLength = 0;
+        uint32_t segmentLength = 0;
+        uint32_t blockCount = 0;
+    };
+
+    uint32_t IndexAlpha(const Instance& in, uint32_t pass, uint32_t slice, uint32_t index,
+        uint32_t pseudoRand, bool sameLane) {
+        uint32_t area;
+        if (pass == 0) {
+            if (slice == 0) area = index - 1;
+            else if (sameLane) area = slice * in.segmentLength + index - 1;
+            else area = slice * in.segmentLength + (index == 0 ? (uint32_t)-1 : 0);
+        } else {
+            if (sameLane) area = in.laneLength - in.segmentLength + index - 1;
+            else area = in.laneLength - in.segmentLength + (index == 0 ? (uint32_t)-1 : 0);
+        }
+        uint64_t rel = pseudoRand;
+        rel = (rel * rel) >> 32;
+        rel = area - 1 - (((uint64_t)area * rel) >> 32);
+        uint32_t start = 0;
+        if (pass != 0) start = (slice == kSyncPoints - 1) ? 0 : (slice + 1) * in.segmentLength;
+        return (uint32_t)((start + rel) % in.laneLength);
+    }
+
+    void FillSegment(const Instance& in, uint32_t pass, uint32_t lane, uint32_t slice) {
+        const bool independent = pass == 0 && slice < kSyncPoints / 2;
+        Block zero{};
+        Block input{};
+        Block addresses{};
+        if (independent) {
+            input.v[0] = pass;
+            input.v[1] = lane;
+            input.v[2] = slice;
+            input.v[3] = in.blockCount;
+            input.v[4] = in.passes;
+            input.v[5] = kTypeId;
+        }
+        auto nextAddresses = [&]() {
+            input.v[6]++;
+            FillBlock(zero, input, addresses, false);
+            FillBlock(zero, addresses, addresses, false);
+        };
+
+        uint32_t start = 0;
+        if (pass == 0 && slice == 0) {
+            start = 2;
+            if (independent) nextAddresses();
+        }
+        uint32_t cur = lane * in.laneLength + slice * in.segmentLength + start;
+        uint32_t prev = (cur % in.laneLength == 0) ? cur + in.laneLength - 1 : cur - 1;
+
+        for (uint32_t i = start; i < in.segmentLength; ++i, ++cur, ++prev) {
+            if (cur % in.laneLength == 1) prev = cur - 1;
+            uint64_t pseudoRand;
+            if (independent) {
+                if (i % kAddressesInBlock == 0) nextAddresses();
+                pseudoRand = addresses.v[i % kAddressesInBlock];
+            } else {
+                pseudoRand = in.memory[prev].v[0];
+            }
+            uint32_t refLane = (uint32_t)((pseudoRand >> 32) % in.lanes);
+            if (pass == 0 && slice == 0) refLane = lane;
+            uint32_t refIndex = IndexAlpha(in, pass, slice, i, (uint32_t)pseudoRand, refLane == lane);
+            const Block& ref = in.memory[(uint64_t)in.laneLength * refLane + refIndex];
+            FillBlock(in.memory[prev], ref, in.memory[cur], pass != 0);
+        }
+    }
+
+    double MeasureMs(const kdf::Argon2Params& params) {
+        unsigned char salt[16] = {};
+        unsigned char out[32];
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = kdf::Argon2id("calibrate", 9, salt, sizeof(salt), params, out, sizeof(out));
+        auto t1 = std::chrono::steady_clock::now();
+        if (!ok) return 0.0;
+        return std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }
+}
+
+namespace kdf {
+    bool Argon2id(const void* password, size_t passwordLen,
+        const void* salt, size_t saltLen,
+        const Argon2Params& params, unsigned char* out, size_t outLen,
+        const void* secret, size_t secretLen, const void* data, size_t dataLen) {
+        if (params.passes < 1 || params.lanes < 1 || params.lanes > 0xFFFFFF) return false;
+        if (params.memoryKiB < 8 * params.lanes || saltLen < 8 || outLen < 4) return false;
+
+        Instance in;
+        in.passes = params.passes;
+        in.lanes = params.lanes;
+        in.segmentLength = params.memoryKiB / (kSyncPoints * params.lanes);
+        in.laneLength = in.segmentLength * kSyncPoints;
+        in.blockCount = in.laneLength * params.lanes;
+
+        std::unique_ptr<Block[]> memory(new (std::nothrow) Block[in.blockCount]);
+        if (!memory) return false;
+        in.memory = memory.get();
+
+        unsigned char h0[64 + 8];
+        {
+            Blake2b h(64);
+            h.UpdateU32(params.lanes);
+            h.UpdateU32((uint32_t)outLen);
+            h.UpdateU32(params.memoryKiB);
+            h.UpdateU32(params.passes);
+            h.UpdateU32(kVersion);
+            h.UpdateU32(kTypeId);
+            h.UpdateU32((uint32_t)passwordLen);
+            h.Update(password, passwordLen);
+            h.UpdateU32((uint32_t)saltLen);
+            h.Update(salt, saltLen);
+            h.UpdateU32((uint32_t)secretLen);
+            h.Update(secret, secretLen);
+            h.UpdateU32((uint32_t)dataLen);
+            h.Update(data, dataLen);
+            h.Final(h0);
+        }
+
+        unsigned char bytes[sizeof(Block)];
+        for (uint32_t l = 0; l < params.lanes; ++l) {
+            for (uint32_t j = 0; j < 2; ++j) {
+                Store32(h0 + 64, j);
+                Store32(h0 + 68, l);
+                HashLong(bytes, sizeof(bytes), h0, sizeof(h0));
+                Block& b = in.memory[(uint64_t)l * in.laneLength + j];
+                for (uint32_t w = 0; w < kBlockWords; ++w) b.v[w] = Load64(bytes + 8 * w);
+            }
+        }
+        crypto::SecureZero(h0, sizeof(h0));
+
+        for (uint32_t pass = 0; pass < in.passes; ++pass) {
+            for (uint32_t slice = 0; slice < kSyncPoints; ++slice) {
+                if (in.lanes == 1) {
+                    FillSegment(in, pass, 0, slice);
+                    continue;
+                }
+                std::vector<std::thread> workers;
+                workers.reserve(in.lanes - 1);
+                for (uint32_t l = 1; l < in.lanes; ++l) {
+                    workers.emplace_back(FillSegment, std::cref(in), pass, l, slice);
+                }
+                FillSegment(in, pass, 0, slice);
+                for (auto& w : workers) w.join();
+            }
+        }
+
+        Block final = in.memory[in.laneLength - 1];
+        for (uint32_t l = 1; l < in.lanes; ++l) {
+            const Block& last = in.memory[(uint64_t)l * in.laneLength + in.laneLength - 1];
+            for (uint32_t w = 0; w < kBlockWords; ++w) final.v[w] ^= last.v[w];
+        }
+        for (uint32_t w = 0; w < kBlockWords; ++w) Store64(bytes + 8 * w, final.v[w]);
+        HashLong(out, outLen, bytes, sizeof(bytes));
+
+        crypto::SecureZero(bytes, sizeof(bytes));
+        crypto::SecureZero(&final, sizeof(final));
+        crypto::SecureZero(in.memory, sizeof(Block) * (size_t)in.blockCount);
+        return true;
+    }
+
+    Argon2Params Calibrate(unsigned targetMs) {
+        static std::mutex lock;
+        static double msPerKiBPass = 0.0;
+        static uint32_t lanes = 0;
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (lanes == 0) {
+            lanes = std::max(1u, std::min(kMaxLanes, std::thread::hardware_concurrency()));
+            Argon2Params probe;
+            probe.passes = 1;
+            probe.memoryKiB = kProbeMemoryKiB;
+            probe.lanes = lanes;
+            double ms = std::min(MeasureMs(probe), MeasureMs(probe));
+            msPerKiBPass = ms > 0.0 ? ms / kProbeMemoryKiB : 0.0;
+        }
+
+        // Prefer memory over passes: three passes over as much memory as the
+        // budget allows, then extra passes once the memory cap is reached.
+        Argon2Params p;
+        p.lanes = lanes;
+        p.passes = 3;
+        double budget = msPerKiBPass > 0.0 ? targetMs / msPerKiBPass : (double)kMinMemoryKiB * 3;
+        double mem = budget / 3;
+        if (mem > kMaxMemoryKiB) {
+            mem = kMaxMemoryKiB;
+            p.passes = (uint32_t)std::min((double)kMaxPasses, budget / kMaxMemoryKiB);
+        } else if (mem < kMinMemoryKiB) {
+            mem = kMinMemoryKiB;
+            p.passes = (uint32_t)std::max(1.0, std::min(3.0, budget / kMinMemoryKiB));
+        }
+        uint32_t unit = 4 * lanes;
+        p.memoryKiB = std::max(8 * lanes, ((uint32_t)mem / unit) * unit);
+        return p;
+    }
+}
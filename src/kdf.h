@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kdf {
+    // The largest parameters Calibrate picks. Anything above them did not
+    // come from us, so a header asking for more is refused before hashing.
+    const uint32_t kMaxPasses = 10;
+    const uint32_t kMaxMemoryKiB = 1024 * 1024;
+    const uint32_t kMaxLanes = 8;
+
+    struct Argon2Params {
+        uint32_t passes = 0;
+        uint32_t memoryKiB = 0;
+        uint32_t lanes = 0;
+    };
+
+    // Argon2id (RFC 9106, version 0x13). Lanes are filled on separate threads.
+    // The secret value and associated data are optional inputs of the RFC;
+    // vault keys use neither.
+    bool Argon2id(const void* password, size_t passwordLen,
+        const void* salt, size_t saltLen,
+        const Argon2Params& params, unsigned char* out, size_t outLen,
+        const void* secret = nullptr, size_t secretLen = 0,
+        const void* data = nullptr, size_t dataLen = 0);
+
+    // Picks Argon2id parameters that take roughly targetMs on this machine.
+    // The measurement runs once per process and is reused afterwards.
+    Argon2Params Calibrate(unsigned targetMs);
+}
@@ -0,0 +1,31 @@
+#include "mapped_file.h"
+
+#include <windows.h>
+#include <cstdint>
+
+bool MappedFile::Open(const std::wstring& path) {
+    Close();
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size{};
+    bool ok = GetFileSizeEx(file, &size) && size.QuadPart >= 0 && (uint64_t)size.QuadPart <= SIZE_MAX;
+    // Empty files cannot be mapped; they read as zero bytes.
+    if (ok && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            view_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        ok = view_ != nullptr;
+    }
+    CloseHandle(file);
+    if (ok) size_ = (size_t)size.QuadPart;
+    return ok;
+}
+
+void MappedFile::Close() {
+    if (view_) UnmapViewOfFile(view_);
+    view_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file. Callers read straight out of the mapping,
+// so the file is never copied onto the heap. The view must be closed before
+// the file is replaced or truncated.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::wstring& path);
+    void Close();
+
+    const unsigned char* Data() const { return (const unsigned char*)view_; }
+    size_t Size() const { return size_; }
+
+private:
+    void* view_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,286 @@
+#include "match.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define LSK_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(LSK_SIMD) && defined(__GNUC__)
+#define LSK_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LSK_TARGET_AVX2
+#endif
+
+namespace {
+    const unsigned kFoldRange = 0x0500;
+
+    struct FoldTable {
+        wchar_t map[kFoldRange];
+
+        constexpr FoldTable() : map() {
+            for (unsigned c = 0; c < kFoldRange; ++c) map[c] = (wchar_t)c;
+            for (unsigned c = 'A'; c <= 'Z'; ++c) map[c] = (wchar_t)(c + 0x20);
+            for (unsigned c = 0xC0; c <= 0xDE; ++c) {
+                if (c != 0xD7) map[c] = (wchar_t)(c + 0x20);
+            }
+            // Latin Extended-A pairs capitals with the next code point,
+            // switching parity at U+0139 and U+0179.
+            for (unsigned c = 0x100; c < 0x138; c += 2) map[c] = (wchar_t)(c + 1);
+            map[0x130] = L'i';
+            for (unsigned c = 0x139; c < 0x149; c += 2) map[c] = (wchar_t)(c + 1);
+            for (unsigned c = 0x14A; c < 0x178; c += 2) map[c] = (wchar_t)(c + 1);
+            map[0x178] = 0xFF;
+            for (unsigned c = 0x179; c < 0x17F; c += 2) map[c] = (wchar_t)(c + 1);
+            map[0x17F] = L's';
+
+            map[0x386] = 0x3AC;
+            for (unsigned c = 0x388; c <= 0x38A; ++c) map[c] = (wchar_t)(c + 0x25);
+            map[0x38C] = 0x3CC;
+            map[0x38E] = 0x3CD;
+            map[0x38F] = 0x3CE;
+            for (unsigned c = 0x391; c <= 0x3AB; ++c) {
+                if (c != 0x3A2) map[c] = (wchar_t)(c + 0x20);
+            }
+            map[0x3C2] = 0x3C3;
+
+            for (unsigned c = 0x400; c <= 0x40F; ++c) map[c] = (wchar_t)(c + 0x50);
+            for (unsigned c = 0x410; c <= 0x42F; ++c) map[c] = (wchar_t)(c + 0x20);
+            for (unsigned c = 0x460; c < 0x482; c += 2) map[c] = (wchar_t)(c + 1);
+            for (unsigned c = 0x48A; c < 0x4C0; c += 2) map[c] = (wchar_t)(c + 1);
+            map[0x4C0] = 0x4CF;
+            for (unsigned c = 0x4C1; c < 0x4CF; c += 2) map[c] = (wchar_t)(c + 1);
+            for (unsigned c = 0x4D0; c < 0x500; c += 2) map[c] = (wchar_t)(c + 1);
+        }
+    };
+
+    constexpr FoldTable kFold;
+
+    inline uint32_t FoldUnit(uint32_t c) {
+        return c < kFoldRange ? (uint32_t)kFold.map[c] : c;
+    }
+
+    struct Needle {
+        const wchar_t* folded;
+        size_t size;
+        const wchar_t* first;
+        int firstCount;
+    };
+
+    // The first unit already matched; compare the rest folded.
+    template <typename Unit>
+    bool Rest(const Unit* at, const Needle& n) {
+        for (size_t k = 1; k < n.size; ++k) {
+            if (FoldUnit((uint32_t)at[k]) != (uint32_t)n.folded[k]) return false;
+        }
+        return true;
+    }
+
+    // Tries every start in [i, starts).
+    template <typename Unit>
+    bool ScanScalar(const Unit* hay, size_t i, size_t starts, const Needle& n) {
+        const uint32_t first = (uint32_t)n.folded[0];
+        for (; i < starts; ++i) {
+            if (FoldUnit((uint32_t)hay[i]) == first && Rest(hay + i, n)) return true;
+        }
+        return false;
+    }
+
+#ifdef LSK_SIMD
+    inline unsigned LowestBit(unsigned bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctz(bits);
+#endif
+    }
+
+    bool HasAvx2() {
+        static const bool has = []() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }();
+        return has;
+    }
+
+    // Both scanners compare a block of UTF-16 units against every unfolded
+    // form of the needle's first character and verify only the lanes that
+    // hit. movemask yields two bits per 16-bit lane. They advance i past the
+    // blocks they covered; the caller finishes the tail.
+    bool ScanSse2(const uint16_t* hay, size_t& i, size_t starts, const Needle& n) {
+        __m128i first[search::Pattern::kMaxFirst];
+        for (int j = 0; j < n.firstCount; ++j) first[j] = _mm_set1_epi16((short)n.first[j]);
+        for (; i + 8 <= starts; i += 8) {
+            const __m128i block = _mm_loadu_si128((const __m128i*)(hay + i));
+            __m128i eq = _mm_cmpeq_epi16(block, first[0]);
+            for (int j = 1; j < n.firstCount; ++j) eq = _mm_or_si128(eq, _mm_cmpeq_epi16(block, first[j]));
+            unsigned bits = (unsigned)_mm_movemask_epi8(eq);
+            while (bits) {
+                if (Rest(hay + i + LowestBit(bits) / 2, n)) return true;
+                bits &= bits - 1;
+                bits &= bits - 1;
+            }
+        }
+        return false;
+    }
+
+    LSK_TARGET_AVX2 bool ScanAvx2(const uint16_t* hay, size_t& i, size_t starts, const Needle& n) {
+        __m256i first[search::Pattern::kMaxFirst];
+        for (int j = 0; j < n.firstCount; ++j) first[j] = _mm256_set1_epi16((short)n.first[j]);
+        for (; i + 16 <= starts; i += 16) {
+            const __m256i block = _mm256_loadu_si256((const __m256i*)(hay + i));
+            __m256i eq = _mm256_cmpeq_epi16(block, first[0]);
+            for (int j = 1; j < n.firstCount; ++j) eq = _mm256_or_si256(eq, _mm256_cmpeq_epi16(block, first[j]));
+            unsigned bits = (unsigned)_mm256_movemask_epi8(eq);
+            while (bits) {
+                if (Rest(hay + i + LowestBit(bits) / 2, n)) return true;
+                bits &= bits - 1;
+                bits &= bits - 1;
+            }
+        }
+        return false;
+    }
+#endif
+}
+
+namespace {
+    const int kScoreMatch = 16;
+    const int kGapStart = 3;
+    const int kGapExtension = 1;
+    const int kBonusBoundary = 8;
+    const int kBonusConsecutive = 4;
+    const int kFirstCharMultiplier = 2;
+
+    bool IsDelimiter(wchar_t c) {
+        if (c == L' ' || c == L'\t' || c == 0xA0) return true;
+        return c < 0x80 && c > L' ' && !((c >= L'0' && c <= L'9') || (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z'));
+    }
+
+    int Bonus(const wchar_t* hay, size_t i) {
+        if (IsDelimiter(hay[i])) return kBonusBoundary / 2;
+        return (i == 0 || IsDelimiter(hay[i - 1])) ? kBonusBoundary : 0;
+    }
+}
+
+namespace search {
+    wchar_t Fold(wchar_t c) {
+        return (wchar_t)FoldUnit((uint32_t)c);
+    }
+
+    Pattern::Pattern(const std::wstring& text) {
+        folded_.reserve(text.size());
+        for (wchar_t c : text) folded_.push_back(Fold(c));
+        if (folded_.empty()) return;
+        const wchar_t f = folded_[0];
+        first_[firstCount_++] = f;
+        for (unsigned c = 0; c < kFoldRange && firstCount_ < kMaxFirst; ++c) {
+            if ((wchar_t)c != f && kFold.map[c] == f) first_[firstCount_++] = (wchar_t)c;
+        }
+    }
+
+    bool Contains(const wchar_t* hay, size_t len, const Pattern& p) {
+        if (p.folded_.empty()) return true;
+        if (len < p.folded_.size()) return false;
+        const Needle n = { p.folded_.data(), p.folded_.size(), p.first_, p.firstCount_ };
+        const size_t starts = len - n.size + 1;
+#ifdef LSK_SIMD
+        if (sizeof(wchar_t) == 2) {
+            const uint16_t* units = (const uint16_t*)hay;
+            size_t i = 0;
+            if (HasAvx2() && ScanAvx2(units, i, starts, n)) return true;
+            if (ScanSse2(units, i, starts, n)) return true;
+            return ScanScalar(units, i, starts, n);
+        }
+#endif
+        return ScanScalar(hay, 0, starts, n);
+    }
+
+    bool Supported(Scanner scanner) {
+        if (scanner == Scanner::kScalar) return true;
+#ifdef LSK_SIMD
+        if (sizeof(wchar_t) == 2) return scanner == Scanner::kSse2 || HasAvx2();
+#endif
+        return false;
+    }
+
+    bool ContainsWith(Scanner scanner, const wchar_t* hay, size_t len, const Pattern& p) {
+        if (p.folded_.empty()) return true;
+        if (len < p.folded_.size()) return false;
+        const Needle n = { p.folded_.data(), p.folded_.size(), p.first_, p.firstCount_ };
+        const size_t starts = len - n.size + 1;
+#ifdef LSK_SIMD
+        if (sizeof(wchar_t) == 2 && scanner != Scanner::kScalar) {
+            const uint16_t* units = (const uint16_t*)hay;
+            size_t i = 0;
+            const bool hit = scanner == Scanner::kAvx2 ? ScanAvx2(units, i, starts, n) : ScanSse2(units, i, starts, n);
+            return hit || ScanScalar(units, i, starts, n);
+        }
+#endif
+        return ScanScalar(hay, 0, starts, n);
+    }
+
+    // Greedy, in two passes: the first occurrence of the subsequence fixes
+    // where the match ends, walking back from there finds the tightest
+    // start, and only that window is scored. Linear in len.
+    int FuzzyScore(const wchar_t* folded, size_t len, const Pattern& p) {
+        const std::wstring& needle = p.folded_;
+        const size_t n = needle.size();
+        if (n == 0) return 0;
+        size_t j = 0;
+        size_t end = 0;
+        for (size_t i = 0; i < len; ++i) {
+            if (folded[i] == needle[j] && ++j == n) {
+                end = i + 1;
+                break;
+            }
+        }
+        if (j < n) return kNoMatch;
+        size_t start = end;
+        while (j > 0) {
+            if (folded[--start] == needle[j - 1]) --j;
+        }
+
+        int score = 0;
+        int run = 0;
+        int runBonus = 0;
+        bool gap = false;
+        for (size_t i = start; i < end; ++i) {
+            if (j < n && folded[i] == needle[j]) {
+                int bonus = Bonus(folded, i);
+                if (run > 0) {
+                    bonus = std::max(bonus, std::max(runBonus, kBonusConsecutive));
+                } else {
+                    runBonus = bonus;
+                }
+                if (j == 0) bonus *= kFirstCharMultiplier;
+                score += kScoreMatch + bonus;
+                ++run;
+                ++j;
+                gap = false;
+            } else {
+                score -= gap ? kGapExtension : kGapStart;
+                run = 0;
+                gap = true;
+            }
+        }
+        return score;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace search {
+    // Simple case folding from a fixed table covering Latin-1, Latin
+    // Extended-A, Greek and Cyrillic; independent of the C runtime locale.
+    // Other characters fold to themselves.
+    wchar_t Fold(wchar_t c);
+
+    // The kernels Contains picks between; exposed so they can be checked
+    // against each other.
+    enum class Scanner { kScalar, kSse2, kAvx2 };
+
+    // False for a SIMD scanner the build or the CPU lacks.
+    bool Supported(Scanner scanner);
+
+    // A needle folded once up front. Every unfolded form of its first
+    // character is kept so haystacks can be scanned for candidates without
+    // folding them.
+    class Pattern {
+    public:
+        static const int kMaxFirst = 4;
+
+        explicit Pattern(const std::wstring& text);
+
+        const std::wstring& Folded() const { return folded_; }
+        size_t Size() const { return folded_.size(); }
+
+    private:
+        friend bool Contains(const wchar_t* hay, size_t len, const Pattern& p);
+        friend bool ContainsWith(Scanner scanner, const wchar_t* hay, size_t len, const Pattern& p);
+        friend int FuzzyScore(const wchar_t* folded, size_t len, const Pattern& p);
+
+        std::wstring folded_;
+        wchar_t first_[kMaxFirst] = {};
+        int firstCount_ = 0;
+    };
+
+    // Case-insensitive substring test; allocates nothing.
+    bool Contains(const wchar_t* hay, size_t len, const Pattern& p);
+
+    // Contains run with one scanner, which must be Supported; the scalar
+    // loop finishes the tail.
+    bool ContainsWith(Scanner scanner, const wchar_t* hay, size_t len, const Pattern& p);
+
+    inline bool Contains(const std::wstring& hay, const Pattern& p) {
+        return Contains(hay.data(), hay.size(), p);
+    }
+
+    const int kNoMatch = -0x7FFFFFFF;
+
+    // fzf-style score for p as a subsequence of already folded text:
+    // matched characters earn more at word starts and in runs, gaps cost.
+    // Returns kNoMatch if p is not a subsequence.
+    int FuzzyScore(const wchar_t* folded, size_t len, const Pattern& p);
+}
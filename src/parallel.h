@@ -0,0 +1,30 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+    // minBlock for loops that open or seal one secret per item, a few
+    // microseconds each: below this many items a thread costs more than it
+    // saves.
+    const size_t kMinSecretsPerThread = 256;
+
+    // Splits [0, count) into contiguous blocks, one per hardware thread but
+    // none smaller than minBlock, and runs fn(begin, end) on each. The
+    // calling thread takes the first block; returns once all are done.
+    template <typename Fn>
+    void ForBlocks(size_t count, size_t minBlock, const Fn& fn) {
+        const size_t threads = std::max<size_t>(1,
+            std::min<size_t>(std::thread::hardware_concurrency(), count / std::max<size_t>(minBlock, 1)));
+        const size_t per = (count + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (size_t t = 1; t < threads; ++t) {
+            workers.emplace_back([&fn, count, per, t]() { fn(std::min(count, t * per), std::min(count, (t + 1) * per)); });
+        }
+        fn(0, std::min(count, per));
+        for (auto& w : workers) w.join();
+    }
+}
@@ -1,32 +1,347 @@
 #include "password_gen.h"
+#include "crypto.h"
+#include "wordlist.h"
 
-#include <windows.h>
-#include <bcrypt.h>
-#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
 namespace {
-    wchar_t RandomChar(const std::wstring& pool) {
-        ULONG idx = 0;
-        BCryptGenRandom(nullptr, (PUCHAR)&idx, sizeof(idx), BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-        return pool[idx % pool.size()];
+    using passgen::kClasses;
+
+    const double kNever = -std::numeric_limits<double>::infinity();
+
+    // Class of every printable ASCII character, or -1 for those never used,
+    // and which ones are easily mistaken for another.
+    struct CharTable {
+        signed char cls[128];
+        bool similar[128];
+
+        constexpr CharTable() : cls(), similar() {
+            for (int c = 0; c < 128; ++c) cls[c] = -1;
+            for (int c = 'a'; c <= 'z'; ++c) cls[c] = passgen::kLower;
+            for (int c = 'A'; c <= 'Z'; ++c) cls[c] = passgen::kUpper;
+            for (int c = '0'; c <= '9'; ++c) cls[c] = passgen::kDigits;
+            const char symbols[] = "!@#$%^&*()-_=+[]{};:,.<>/?";
+            for (int i = 0; symbols[i]; ++i) cls[(int)symbols[i]] = passgen::kSymbols;
+            const char lookalikes[] = "0O1lI";
+            for (int i = 0; lookalikes[i]; ++i) similar[(int)lookalikes[i]] = true;
+        }
+    };
+
+    constexpr CharTable kChars;
+
+    double LogAdd(double a, double b) {
+        if (a == kNever) return b;
+        if (b == kNever) return a;
+        const double hi = std::max(a, b);
+        return hi + std::log1p(std::exp(std::min(a, b) - hi));
+    }
+
+    // Uniform in [0, 1) with 53 random bits.
+    bool Unit(crypto::RandomBuffer& rng, double& out) {
+        uint64_t v = 0;
+        if (!rng.Bytes(&v, sizeof(v))) return false;
+        out = (double)(v >> 11) * (1.0 / 9007199254740992.0);
+        return true;
+    }
+
+    // Counts, in log space, the passwords a policy allows, and draws from
+    // them uniformly in one pass: first the classes of the two ends, then
+    // how many of each class the middle holds, then where they go, then the
+    // characters. Each step is weighted by the number of passwords it
+    // leaves, so nothing is generated twice.
+    class Plan {
+    public:
+        explicit Plan(const passgen::Policy& policy);
+
+        bool Valid() const { return total_ != kNever; }
+        double Bits() const { return Valid() ? total_ / std::log(2.0) : 0; }
+        bool Draw(crypto::RandomBuffer& rng, std::vector<int>& classes, std::wstring& out) const;
+
+    private:
+        // A choice of first and last class, with the bounds they leave for
+        // the middle. tail[c * (middle + 1) + r] is the log of the ways
+        // classes c and up can fill r middle positions, each weighted by
+        // pool size^count / count!.
+        struct Ends {
+            int first = 0;
+            int last = 0;
+            double weight = kNever;
+            int lo[kClasses] = {};
+            int hi[kClasses] = {};
+            std::vector<double> tail;
+        };
+
+        double Term(int c, int k) const {
+            return k == 0 ? 0 : k * logSize_[c] - logFactorial_[k];
+        }
+        void Count(Ends& e, int middle) const;
+        bool Pick(crypto::RandomBuffer& rng, const Ends& e, int c, int r, int& k) const;
+
+        int length_ = 0;
+        std::wstring pools_[kClasses];
+        double logSize_[kClasses] = {};
+        std::vector<double> logFactorial_;
+        // With no counts or ends to meet, every character is drawn from all.
+        bool simple_ = false;
+        std::wstring all_;
+        std::vector<Ends> ends_;
+        double total_ = kNever;
+    };
+
+    Plan::Plan(const passgen::Policy& p) : length_(p.length) {
+        if (length_ <= 0) return;
+        for (int c = 0x21; c < 0x7F; ++c) {
+            const int cls = kChars.cls[c];
+            if (cls < 0 || !p.use[cls]) continue;
+            if (p.excludeSimilar && kChars.similar[c]) continue;
+            if (p.exclude.find((wchar_t)c) != std::wstring::npos) continue;
+            pools_[cls].push_back((wchar_t)c);
+        }
+        int lo[kClasses];
+        int hi[kClasses];
+        unsigned used = 0;
+        bool bounded = false;
+        for (int c = 0; c < kClasses; ++c) {
+            lo[c] = std::max(p.minimum[c], 0);
+            hi[c] = pools_[c].empty() ? 0 : p.maximum[c] < 0 ? length_ : std::min(p.maximum[c], length_);
+            if (lo[c] > hi[c]) return;
+            if (!pools_[c].empty()) {
+                used |= 1u << c;
+                bounded = bounded || lo[c] > 0 || hi[c] < length_;
+            }
+            logSize_[c] = pools_[c].empty() ? kNever : std::log((double)pools_[c].size());
+        }
+        if (!used) return;
+
+        if (!bounded && (p.first & used) == used && (p.last & used) == used) {
+            simple_ = true;
+            for (const auto& pool : pools_) all_ += pool;
+            total_ = length_ * std::log((double)all_.size());
+            return;
+        }
+
+        logFactorial_.assign(length_ + 1, 0);
+        for (int k = 1; k <= length_; ++k) logFactorial_[k] = logFactorial_[k - 1] + std::log((double)k);
+        const int middle = length_ == 1 ? 0 : length_ - 2;
+        for (int a = 0; a < kClasses; ++a) {
+            if (!(p.first & used & (1u << a))) continue;
+            for (int b = 0; b < kClasses; ++b) {
+                if (!(p.last & used & (1u << b))) continue;
+                if (length_ == 1 && a != b) continue;
+                Ends e;
+                e.first = a;
+                e.last = b;
+                bool fits = true;
+                for (int c = 0; c < kClasses; ++c) {
+                    const int fixed = (c == a) + (length_ > 1 && c == b);
+                    e.lo[c] = std::max(lo[c] - fixed, 0);
+                    e.hi[c] = hi[c] - fixed;
+                    fits = fits && e.hi[c] >= 0;
+                }
+                if (!fits) continue;
+                Count(e, middle);
+                if (e.weight == kNever) continue;
+                total_ = LogAdd(total_, e.weight);
+                ends_.push_back(std::move(e));
+            }
+        }
+    }
+
+    void Plan::Count(Ends& e, int middle) const {
+        const int width = middle + 1;
+        e.tail.assign((kClasses + 1) * width, kNever);
+        e.tail[kClasses * width] = 0;
+        for (int c = kClasses - 1; c >= 0; --c) {
+            for (int r = 0; r <= middle; ++r) {
+                double sum = kNever;
+                for (int k = e.lo[c]; k <= std::min(e.hi[c], r); ++k) {
+                    const double rest = e.tail[(c + 1) * width + r - k];
+                    if (rest != kNever) sum = LogAdd(sum, Term(c, k) + rest);
+                }
+                e.tail[c * width + r] = sum;
+            }
+        }
+        if (e.tail[middle] == kNever) return;
+        e.weight = logSize_[e.first] + (length_ > 1 ? logSize_[e.last] : 0) + logFactorial_[middle] + e.tail[middle];
+    }
+
+    // How many of the r positions left class c takes.
+    bool Plan::Pick(crypto::RandomBuffer& rng, const Ends& e, int c, int r, int& k) const {
+        const int width = (int)e.tail.size() / (kClasses + 1);
+        const double whole = e.tail[c * width + r];
+        double u = 0;
+        if (!Unit(rng, u)) return false;
+        double acc = 0;
+        for (int n = e.lo[c]; n <= std::min(e.hi[c], r); ++n) {
+            const double rest = e.tail[(c + 1) * width + r - n];
+            if (rest == kNever) continue;
+            k = n;
+            acc += std::exp(Term(c, n) + rest - whole);
+            if (u < acc) break;
+        }
+        return true;
+    }
+
+    bool Plan::Draw(crypto::RandomBuffer& rng, std::vector<int>& classes, std::wstring& out) const {
+        out.clear();
+        if (!Valid()) return false;
+        auto put = [&](int c) {
+            uint32_t idx = 0;
+            if (!rng.Uniform((uint32_t)pools_[c].size(), idx)) return false;
+            out.push_back(pools_[c][idx]);
+            return true;
+        };
+        if (simple_) {
+            for (int i = 0; i < length_; ++i) {
+                uint32_t idx = 0;
+                if (!rng.Uniform((uint32_t)all_.size(), idx)) return false;
+                out.push_back(all_[idx]);
+            }
+            return true;
+        }
+
+        double u = 0;
+        if (!Unit(rng, u)) return false;
+        const Ends* e = &ends_.back();
+        double acc = 0;
+        for (const auto& candidate : ends_) {
+            acc += std::exp(candidate.weight - total_);
+            if (u < acc) {
+                e = &candidate;
+                break;
+            }
+        }
+        int r = (int)e->tail.size() / (kClasses + 1) - 1;
+        classes.clear();
+        for (int c = 0; c < kClasses; ++c) {
+            int k = 0;
+            if (!Pick(rng, *e, c, r, k)) return false;
+            classes.insert(classes.end(), k, c);
+            r -= k;
+        }
+        for (size_t i = classes.size(); i > 1; --i) {
+            uint32_t j = 0;
+            if (!rng.Uniform((uint32_t)i, j)) return false;
+            std::swap(classes[i - 1], classes[j]);
+        }
+        if (!put(e->first)) return false;
+        for (int c : classes) {
+            if (!put(c)) return false;
+        }
+        return length_ == 1 || put(e->last);
+    }
+
+    passgen::Policy FlagPolicy(int length, bool lower, bool upper, bool digits, bool symbols) {
+        passgen::Policy p;
+        p.length = length;
+        p.use[passgen::kLower] = lower || !(upper || digits || symbols);
+        p.use[passgen::kUpper] = upper;
+        p.use[passgen::kDigits] = digits;
+        p.use[passgen::kSymbols] = symbols;
+        return p;
+    }
+
+    bool FillPhrase(crypto::RandomBuffer& rng, const passgen::PhraseOptions& o, std::wstring& out) {
+        out.clear();
+        uint32_t digitWord = 0;
+        if (o.digits > 0 && !rng.Uniform((uint32_t)o.words, digitWord)) return false;
+        for (int i = 0; i < o.words; ++i) {
+            uint32_t idx = 0;
+            if (!rng.Uniform((uint32_t)passgen::kWordCount, idx)) return false;
+            if (i > 0) out += o.separator;
+            const size_t start = out.size();
+            out += passgen::kWords[idx];
+            if (o.capitalize) out[start] = (wchar_t)(out[start] - L'a' + L'A');
+            if (o.digits > 0 && (uint32_t)i == digitWord) {
+                for (int d = 0; d < o.digits; ++d) {
+                    uint32_t digit = 0;
+                    if (!rng.Uniform(10, digit)) return false;
+                    out.push_back((wchar_t)(L'0' + digit));
+                }
+            }
+        }
+        return true;
     }
 }
 
 namespace passgen {
+    std::wstring Generate(const Policy& policy) {
+        const Plan plan(policy);
+        crypto::RandomBuffer rng;
+        std::vector<int> classes;
+        std::wstring out;
+        if (!plan.Draw(rng, classes, out)) return L"";
+        return out;
+    }
+
+    bool Generate(size_t count, const Policy& policy, std::vector<std::wstring>& out) {
+        out.clear();
+        const Plan plan(policy);
+        if (!plan.Valid()) {
+            out.clear();
+            return false;
+        }
+        crypto::RandomBuffer rng;
+        std::vector<int> classes;
+        out.resize(count);
+        for (auto& password : out) {
+            if (!plan.Draw(rng, classes, password)) {
+                out.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double Entropy(const Policy& policy) {
+        return Plan(policy).Bits();
+    }
+
     std::wstring Generate(int length, bool lower, bool upper, bool digits, bool symbols) {
-        if (length <= 0) return L"";
-        std::wstring pool;
-        if (lower) pool += L"abcdefghijklmnopqrstuvwxyz";
-        if (upper) pool += L"ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-        if (digits) pool += L"0123456789";
-        if (symbols) pool += L"!@#$%^&*()-_=+[]{};:,.<>/?";
-        if (pool.empty()) pool = L"abcdefghijklmnopqrstuvwxyz";
+        return Generate(FlagPolicy(length, lower, upper, digits, symbols));
+    }
+
+    bool Generate(size_t count, int length, bool lower, bool upper, bool digits, bool symbols,
+        std::vector<std::wstring>& out) {
+        return Generate(count, FlagPolicy(length, lower, upper, digits, symbols), out);
+    }
+
+    double Entropy(int length, bool lower, bool upper, bool digits, bool symbols) {
+        return Entropy(FlagPolicy(length, lower, upper, digits, symbols));
+    }
 
+    std::wstring Passphrase(const PhraseOptions& options) {
+        if (options.words <= 0) return L"";
+        crypto::RandomBuffer rng;
         std::wstring out;
-        out.reserve(length);
-        for (int i = 0; i < length; ++i) {
-            out.push_back(RandomChar(pool));
-        }
+        if (!FillPhrase(rng, options, out)) return L"";
         return out;
     }
+
+    bool Passphrase(size_t count, const PhraseOptions& options, std::vector<std::wstring>& out) {
+        if (options.words <= 0) {
+            out.assign(count, std::wstring());
+            return true;
+        }
+        crypto::RandomBuffer rng;
+        out.resize(count);
+        for (auto& phrase : out) {
+            if (!FillPhrase(rng, options, phrase)) {
+                out.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 11 bits a word, plus the digits and which word carries them.
+    double Entropy(const PhraseOptions& options) {
+        if (options.words <= 0) return 0;
+        double bits = options.words * std::log2((double)kWordCount);
+        if (options.digits > 0) bits += options.digits * std::log2(10.0) + std::log2((double)options.words);
+        return bits;
+    }
 }
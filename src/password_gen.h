@@ -1,7 +1,62 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace passgen {
+    enum CharClass { kLower, kUpper, kDigits, kSymbols, kClasses };
+
+    const unsigned kAnyClass = (1u << kClasses) - 1;
+
+    // What a generated password must look like. Every password meeting the
+    // policy is equally likely.
+    struct Policy {
+        int length = 16;
+        bool use[kClasses] = { true, true, true, false };
+        // At least minimum and at most maximum characters of each class in
+        // use; a negative maximum means no limit.
+        int minimum[kClasses] = {};
+        int maximum[kClasses] = { -1, -1, -1, -1 };
+        // Leaves out look-alikes: 0 and O, 1, l and I.
+        bool excludeSimilar = false;
+        // Further characters never to use.
+        std::wstring exclude;
+        // Classes allowed in the first and last position, as 1 << CharClass
+        // bits.
+        unsigned first = kAnyClass;
+        unsigned last = kAnyClass;
+    };
+
+    // Empty, or false with out empty, if no password meets the policy or
+    // the system RNG fails.
+    std::wstring Generate(const Policy& policy);
+    bool Generate(size_t count, const Policy& policy, std::vector<std::wstring>& out);
+    // Bits of entropy in a password from Generate with this policy: log2 of
+    // the number of passwords that meet it; 0 if none does.
+    double Entropy(const Policy& policy);
+
+    // A policy drawing every character from the union of the classes
+    // chosen, lowercase if none is.
     std::wstring Generate(int length, bool lower, bool upper, bool digits, bool symbols);
+    bool Generate(size_t count, int length, bool lower, bool upper, bool digits, bool symbols,
+        std::vector<std::wstring>& out);
+    double Entropy(int length, bool lower, bool upper, bool digits, bool symbols);
+
+    // Diceware-style passphrase: words from the built-in list joined by
+    // separator. capitalize uppercases each word's first letter; digits
+    // random digits are appended to one randomly chosen word.
+    struct PhraseOptions {
+        int words = 6;
+        std::wstring separator = L"-";
+        bool capitalize = false;
+        int digits = 0;
+    };
+
+    std::wstring Passphrase(const PhraseOptions& options);
+    bool Passphrase(size_t count, const PhraseOptions& options, std::vector<std::wstring>& out);
+    // Bits of entropy in a Passphrase with these options, counting every
+    // random choice. Exact when the separator is non-empty and holds no
+    // letters or digits, so the choices can be read back from the result.
+    double Entropy(const PhraseOptions& options);
 }
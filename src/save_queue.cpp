@@ -0,0 +1,170 @@
+#include "save_queue.h"
+#include "attachments.h"
+
+#include <algorithm>
+
+namespace vault {
+    SaveQueue::~SaveQueue() {
+        Stop();
+    }
+
+    void SaveQueue::Start(const crypto::Session& session, Store& store, const Vault& snapshot, HWND notify, UINT msg,
+        bool sweep) {
+        Stop();
+        session_ = &session;
+        store_ = &store;
+        notify_ = notify;
+        msg_ = msg;
+        sweep_ = sweep;
+        swept_ = store.Checkpoints();
+        mirror_ = snapshot;
+        IndexMirror();
+        worker_ = std::thread([this]() { Run(); });
+    }
+
+    bool SaveQueue::Put(const Entry& e) {
+        Change c;
+        c.id = e.id;
+        c.entry = e;
+        return Queue(std::move(c));
+    }
+
+    bool SaveQueue::Remove(uint64_t id) {
+        Change c;
+        c.id = id;
+        c.remove = true;
+        return Queue(std::move(c));
+    }
+
+    // Only the latest change per entry is kept: changes to different entries
+    // commute, so replacing one in place keeps the batch correct.
+    bool SaveQueue::Queue(Change&& c) {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!worker_.joinable()) return false;
+            auto it = index_.find(c.id);
+            if (it != index_.end()) {
+                changes_[it->second] = std::move(c);
+            } else {
+                index_[c.id] = changes_.size();
+                changes_.push_back(std::move(c));
+            }
+        }
+        wake_.notify_one();
+        return true;
+    }
+
+    bool SaveQueue::Compact(const Vault& snapshot) {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!worker_.joinable()) return false;
+            compact_.reset(new Vault(snapshot));
+            changes_.clear();
+            index_.clear();
+        }
+        wake_.notify_one();
+        return true;
+    }
+
+    bool SaveQueue::Flush() {
+        std::unique_lock<std::mutex> guard(lock_);
+        idle_.wait(guard, [this]() { return !busy_ && changes_.empty() && !compact_; });
+        bool ok = !failed_ && !resync_;
+        failed_ = false;
+        return ok;
+    }
+
+    void SaveQueue::Stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (worker_.joinable()) worker_.join();
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = false;
+        failed_ = false;
+        resync_ = false;
+        changes_.clear();
+        index_.clear();
+        compact_.reset();
+        mirror_ = Vault();
+        mirrorIndex_.clear();
+    }
+
+    // A batch holds at most one change per id. Removals are only marked and
+    // erased together at the end, since erasing shifts every later position
+    // and the index is rebuilt after it.
+    void SaveQueue::Mirror(std::vector<Change>& batch) {
+        EntryTable& entries = mirror_.entries;
+        std::vector<bool> removed;
+        for (auto& c : batch) {
+            auto it = mirrorIndex_.find(c.id);
+            if (c.remove) {
+                if (it == mirrorIndex_.end()) continue;
+                if (removed.empty()) removed.resize(entries.Size());
+                removed[it->second] = true;
+                mirrorIndex_.erase(it);
+            } else if (it != mirrorIndex_.end()) {
+                entries.Replace(it->second, c.entry);
+            } else {
+                mirrorIndex_[c.id] = entries.Size();
+                entries.Append(c.entry);
+                mirror_.nextId = std::max(mirror_.nextId, c.id + 1);
+            }
+        }
+        if (!removed.empty()) {
+            entries.Erase(removed);
+            IndexMirror();
+        }
+    }
+
+    void SaveQueue::IndexMirror() {
+        mirrorIndex_.clear();
+        mirrorIndex_.reserve(mirror_.entries.Size());
+        for (size_t pos = 0; pos < mirror_.entries.Size(); ++pos) mirrorIndex_[mirror_.entries.Id(pos)] = pos;
+    }
+
+    // A failed append leaves the journal behind the UI, so the next write
+    // (or, failing that, one last attempt on Stop) is a full checkpoint of
+    // the mirror instead.
+    void SaveQueue::Run() {
+        std::unique_lock<std::mutex> guard(lock_);
+        for (;;) {
+            wake_.wait(guard, [this]() { return stop_ || compact_ || !changes_.empty(); });
+            const bool full = compact_ || resync_;
+            if (!full && changes_.empty()) break;
+            const bool replaced = compact_ != nullptr;
+            if (replaced) {
+                mirror_ = std::move(*compact_);
+                compact_.reset();
+            }
+            std::vector<Change> batch;
+            batch.swap(changes_);
+            index_.clear();
+            busy_ = true;
+            guard.unlock();
+
+            if (replaced) IndexMirror();
+            Mirror(batch);
+            bool ok = full ? store_->Compact(*session_, mirror_) : store_->Apply(*session_, mirror_, batch);
+            PostMessageW(notify_, msg_, ok, 0);
+            // The mirror is on disk once the write succeeds, so it is safe
+            // to sweep against.
+            if (ok && sweep_) {
+                const uint64_t checkpoints = store_->Checkpoints();
+                if (checkpoints != swept_) {
+                    swept_ = checkpoints;
+                    attachments::Sweep(mirror_);
+                }
+            }
+
+            guard.lock();
+            busy_ = false;
+            resync_ = !ok;
+            failed_ = failed_ || !ok;
+            idle_.notify_all();
+            if (stop_ && changes_.empty() && !compact_) break;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <windows.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "vault.h"
+
+namespace vault {
+    // Writes changes to the store on a worker thread so the UI never waits
+    // on the disk. Changes queued while a write is in flight are merged, by
+    // entry id, into the next one. After every write the worker posts msg to
+    // the notify window with wParam set to whether it succeeded.
+    class SaveQueue {
+    public:
+        SaveQueue() = default;
+        ~SaveQueue();
+        SaveQueue(const SaveQueue&) = delete;
+        SaveQueue& operator=(const SaveQueue&) = delete;
+
+        // snapshot must match what the store holds; the worker keeps its own
+        // copy in step with the queued changes for compaction. With sweep
+        // set, the worker deletes unreferenced attachment objects after each
+        // write that followed a new checkpoint; leave it clear for a vault
+        // that was just created in place of one that did not open.
+        void Start(const crypto::Session& session, Store& store, const Vault& snapshot, HWND notify, UINT msg,
+            bool sweep);
+        // These return false, queueing nothing, unless the queue is started.
+        bool Put(const Entry& e);
+        bool Remove(uint64_t id);
+        // Replaces the whole vault; drops changes still queued before it.
+        bool Compact(const Vault& snapshot);
+        // Waits until everything queued is on disk. Returns false if any
+        // write since the last Flush failed.
+        bool Flush();
+        void Stop();
+
+    private:
+        bool Queue(Change&& c);
+        void Run();
+        void Mirror(std::vector<Change>& batch);
+        void IndexMirror();
+
+        std::mutex lock_;
+        std::condition_variable wake_;
+        std::condition_variable idle_;
+        std::thread worker_;
+        const crypto::Session* session_ = nullptr;
+        Store* store_ = nullptr;
+        HWND notify_ = nullptr;
+        UINT msg_ = 0;
+        bool sweep_ = false;
+        uint64_t swept_ = 0;
+        std::vector<Change> changes_;
+        std::unordered_map<uint64_t, size_t> index_;
+        std::unique_ptr<Vault> compact_;
+        Vault mirror_;
+        // Position of every entry in mirror_, by id; worker-owned.
+        std::unordered_map<uint64_t, size_t> mirrorIndex_;
+        bool busy_ = false;
+        bool stop_ = false;
+        bool failed_ = false;
+        bool resync_ = false;
+    };
+}
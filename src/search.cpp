@@ -0,0 +1,362 @@
+#include "search.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    // Separates fields in a document; never typed into the search box, so
+    // no query can match across two fields.
+    const wchar_t kFieldBreak = L'\n';
+
+    uint64_t Gram(const wchar_t* p) {
+        return ((uint64_t)(p[0] & 0x1FFFFF) << 42) | ((uint64_t)(p[1] & 0x1FFFFF) << 21) | (uint64_t)(p[2] & 0x1FFFFF);
+    }
+
+    void Grams(const std::wstring& folded, std::vector<uint64_t>& out) {
+        out.clear();
+        for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+            const wchar_t* p = &folded[i];
+            if (p[0] == kFieldBreak || p[1] == kFieldBreak || p[2] == kFieldBreak) continue;
+            out.push_back(Gram(p));
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    // Galloping lower_bound: candidates are close together when lists are
+    // dense, so probe forward before falling back to a binary search.
+    std::vector<uint32_t>::const_iterator Seek(std::vector<uint32_t>::const_iterator from,
+        std::vector<uint32_t>::const_iterator end, uint32_t slot) {
+        size_t step = 1;
+        while (from != end && *from < slot) {
+            if ((size_t)(end - from) <= step || from[step] >= slot) {
+                return std::lower_bound(from + 1, std::min(from + step + 1, end), slot);
+            }
+            from += step;
+            step *= 2;
+        }
+        return from;
+    }
+
+    // Title counts most; notes are sealed and never indexed.
+    const int kFieldWeights[] = { 4, 1, 3, 2 };
+
+    // Folded letters and digits get bits of their own so the common ones
+    // never share a bit with URL punctuation.
+    unsigned CharBit(wchar_t c) {
+        if (c >= L'a' && c <= L'z') return c - L'a';
+        if (c >= L'0' && c <= L'9') return 26 + (c - L'0');
+        if (c >= 0x430 && c <= 0x44F) return 36 + ((c - 0x430) & 15);
+        return 52 + (unsigned)c % 12;
+    }
+
+    uint64_t CharMask(const wchar_t* p, const wchar_t* end) {
+        uint64_t mask = 0;
+        for (; p < end; ++p) mask |= 1ull << CharBit(*p);
+        return mask;
+    }
+    const int kExactTier = 1 << 24;
+
+    // Keeps the k best (score, position) pairs in a min-heap, so ranking
+    // never sorts more than k hits. Equal scores keep vault order.
+    class TopK {
+    public:
+        explicit TopK(size_t k) : k_(k) { heap_.reserve(k); }
+
+        size_t Size() const { return heap_.size(); }
+
+        void Push(int score, size_t pos) {
+            const Hit hit = { score, pos };
+            if (heap_.size() < k_) {
+                heap_.push_back(hit);
+                std::push_heap(heap_.begin(), heap_.end(), Better);
+            } else if (Better(hit, heap_.front())) {
+                std::pop_heap(heap_.begin(), heap_.end(), Better);
+                heap_.back() = hit;
+                std::push_heap(heap_.begin(), heap_.end(), Better);
+            }
+        }
+
+        void Drain(std::vector<size_t>& out) {
+            std::sort_heap(heap_.begin(), heap_.end(), Better);
+            for (const auto& h : heap_) out.push_back(h.pos);
+            heap_.clear();
+        }
+
+    private:
+        struct Hit {
+            int score;
+            size_t pos;
+        };
+
+        static bool Better(const Hit& a, const Hit& b) {
+            return a.score != b.score ? a.score > b.score : a.pos < b.pos;
+        }
+
+        size_t k_;
+        std::vector<Hit> heap_;
+    };
+
+    bool IsPrefix(const std::wstring& prefix, const std::wstring& s) {
+        return prefix.size() <= s.size() && std::equal(prefix.begin(), prefix.end(), s.begin());
+    }
+
+    void AppendFolded(std::wstring_view s, std::wstring& out) {
+        for (wchar_t c : s) out.push_back(search::Fold(c));
+        out.push_back(kFieldBreak);
+    }
+
+    void SplitFields(const std::wstring& folded, uint32_t* ends, uint64_t* masks, int fields) {
+        const wchar_t* begin = folded.data();
+        const wchar_t* end = begin + folded.size();
+        const wchar_t* p = begin;
+        for (int f = 0; f < fields; ++f) {
+            const wchar_t* stop = std::find(p, end, kFieldBreak);
+            ends[f] = (uint32_t)(stop - begin);
+            masks[f] = CharMask(p, stop);
+            p = stop == end ? end : stop + 1;
+        }
+    }
+
+    std::wstring Document(const EntryRef& e) {
+        std::wstring out;
+        out.reserve(e.title.size() + e.category.size() + e.username.size() + e.url.size() + 4);
+        AppendFolded(e.title, out);
+        AppendFolded(e.category, out);
+        AppendFolded(e.username, out);
+        AppendFolded(e.url, out);
+        return out;
+    }
+}
+
+namespace search {
+    void Index::Build(const Vault& v) {
+        docs_.clear();
+        slots_.clear();
+        postings_.clear();
+        dead_ = 0;
+        ++generation_;
+        docs_.reserve(v.entries.Size());
+        slots_.reserve(v.entries.Size());
+        for (const auto& e : v.entries) Insert(e);
+    }
+
+    // Slots are handed out in vault order and keep it through erases, so
+    // every posting list, kept sorted by slot, is also in vault order.
+    void Index::Insert(const EntryRef& e) {
+        const uint32_t slot = (uint32_t)docs_.size();
+        ++generation_;
+        Doc d;
+        d.folded = Document(e);
+        SplitFields(d.folded, d.ends, d.masks, kFields);
+        d.pos = slots_.size();
+        std::vector<uint64_t> grams;
+        Grams(d.folded, grams);
+        docs_.push_back(std::move(d));
+        slots_.push_back(slot);
+        Link(slot, grams);
+    }
+
+    // Only the postings for trigrams the edit added or removed change.
+    void Index::Update(size_t pos, const EntryRef& e) {
+        if (pos >= slots_.size()) return;
+        const uint32_t slot = slots_[pos];
+        ++generation_;
+        Doc& d = docs_[slot];
+        std::vector<uint64_t> before, after, diff;
+        Grams(d.folded, before);
+        d.folded = Document(e);
+        SplitFields(d.folded, d.ends, d.masks, kFields);
+        Grams(d.folded, after);
+        std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(diff));
+        Unlink(slot, diff);
+        diff.clear();
+        std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(diff));
+        Link(slot, diff);
+    }
+
+    // Erased documents stay in their posting lists until the dead outnumber
+    // the live, and queries skip them.
+    void Index::Erase(size_t pos) {
+        if (pos >= slots_.size()) return;
+        ++generation_;
+        Doc& d = docs_[slots_[pos]];
+        d.live = false;
+        std::wstring().swap(d.folded);
+        slots_.erase(slots_.begin() + pos);
+        ++dead_;
+        if (dead_ > slots_.size()) {
+            Compact();
+        } else {
+            Renumber();
+        }
+    }
+
+    void Index::Query(const std::wstring& text, std::vector<size_t>& out) const {
+        Matches(Pattern(text), out);
+    }
+
+    void Index::Matches(const Pattern& pattern, std::vector<size_t>& out) const {
+        out.clear();
+        const std::wstring& needle = pattern.Folded();
+
+        if (needle.size() < 3) {
+            for (size_t i = 0; i < slots_.size(); ++i) {
+                if (Contains(docs_[slots_[i]].folded, pattern)) out.push_back(i);
+            }
+            return;
+        }
+
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (size_t i = 0; i + 3 <= needle.size(); ++i) {
+            auto it = postings_.find(Gram(&needle[i]));
+            if (it == postings_.end()) return;
+            lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end());
+        lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+        std::sort(lists.begin(), lists.end(),
+            [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) { return a->size() < b->size(); });
+        // A trigram most documents contain rejects too few candidates to pay
+        // for the intersection; verification catches what it would have.
+        while (lists.size() > 1 && lists.back()->size() > docs_.size() / 2) lists.pop_back();
+
+        // Walk the shortest list; candidates ascend, so each longer list is
+        // searched from where the previous candidate left off.
+        std::vector<std::vector<uint32_t>::const_iterator> cursors;
+        for (size_t i = 1; i < lists.size(); ++i) cursors.push_back(lists[i]->begin());
+        for (uint32_t slot : *lists[0]) {
+            bool all = true;
+            for (size_t i = 1; all && i < lists.size(); ++i) {
+                auto& c = cursors[i - 1];
+                c = Seek(c, lists[i]->end(), slot);
+                all = c != lists[i]->end() && *c == slot;
+            }
+            const Doc& d = docs_[slot];
+            if (all && d.live && Contains(d.folded, pattern)) out.push_back(d.pos);
+        }
+    }
+
+    // Best field score, weighted by field.
+    int Index::Score(const Doc& d, const Pattern& pattern, uint64_t need) const {
+        int best = kNoMatch;
+        uint32_t start = 0;
+        for (int f = 0; f < kFields; ++f) {
+            if ((d.masks[f] & need) == need) {
+                int score = FuzzyScore(d.folded.data() + start, d.ends[f] - start, pattern);
+                if (score != kNoMatch) best = std::max(best, score > 0 ? score * kFieldWeights[f] : score);
+            }
+            start = d.ends[f] + 1;
+        }
+        return best;
+    }
+
+    // Entries containing the query outrank fuzzy-only matches, which are
+    // only looked for when the former leave room in the top k. Each tier
+    // narrows from the last step that computed it: every entry matching a
+    // query also matches each of its prefixes.
+    void QuerySession::Rank(const Index& index, const std::wstring& text, const std::function<bool(size_t)>& accept,
+        size_t k, std::vector<size_t>& out) {
+        out.clear();
+        if (k == 0) return;
+        if (index.generation_ != generation_ || k != k_) {
+            steps_.clear();
+            generation_ = index.generation_;
+            k_ = k;
+        }
+        const Pattern pattern(text);
+        const std::wstring& needle = pattern.Folded();
+        while (!steps_.empty() && !IsPrefix(steps_.back().folded, needle)) steps_.pop_back();
+        if (!steps_.empty() && steps_.back().folded == needle) {
+            out = steps_.back().ranked;
+            return;
+        }
+
+        const uint64_t need = CharMask(needle.data(), needle.data() + needle.size());
+        auto doc = [&](size_t pos) -> const Index::Doc& { return index.docs_[index.slots_[pos]]; };
+        Step step;
+        step.folded = needle;
+        if (steps_.empty()) {
+            index.Matches(pattern, step.exact);
+            step.exact.erase(std::remove_if(step.exact.begin(), step.exact.end(),
+                [&](size_t pos) { return !accept(pos); }), step.exact.end());
+        } else {
+            for (size_t pos : steps_.back().exact) {
+                if (Contains(doc(pos).folded, pattern)) step.exact.push_back(pos);
+            }
+        }
+
+        TopK top(k);
+        for (size_t pos : step.exact) {
+            top.Push(kExactTier + std::max(0, index.Score(doc(pos), pattern, need)), pos);
+        }
+        if (step.exact.size() < k) {
+            const std::vector<size_t>* from = nullptr;
+            for (auto it = steps_.rbegin(); it != steps_.rend() && !from; ++it) {
+                if (it->hasFuzzy) from = &it->fuzzy;
+            }
+            size_t next = 0;
+            auto consider = [&](size_t pos) {
+                const int score = index.Score(doc(pos), pattern, need);
+                if (score == kNoMatch) return;
+                step.fuzzy.push_back(pos);
+                while (next < step.exact.size() && step.exact[next] < pos) ++next;
+                if (next < step.exact.size() && step.exact[next] == pos) return;
+                top.Push(score, pos);
+            };
+            if (from) {
+                for (size_t pos : *from) consider(pos);
+            } else {
+                for (size_t pos = 0; pos < index.slots_.size(); ++pos) {
+                    if (accept(pos)) consider(pos);
+                }
+            }
+            step.hasFuzzy = true;
+        }
+        top.Drain(step.ranked);
+        out = step.ranked;
+        steps_.push_back(std::move(step));
+    }
+
+    void Index::Link(uint32_t slot, const std::vector<uint64_t>& grams) {
+        for (uint64_t g : grams) {
+            auto& list = postings_[g];
+            if (list.empty() || list.back() < slot) {
+                list.push_back(slot);
+            } else {
+                list.insert(std::lower_bound(list.begin(), list.end(), slot), slot);
+            }
+        }
+    }
+
+    void Index::Unlink(uint32_t slot, const std::vector<uint64_t>& grams) {
+        for (uint64_t g : grams) {
+            auto it = postings_.find(g);
+            if (it == postings_.end()) continue;
+            auto& list = it->second;
+            auto at = std::lower_bound(list.begin(), list.end(), slot);
+            if (at != list.end() && *at == slot) list.erase(at);
+            if (list.empty()) postings_.erase(it);
+        }
+    }
+
+    void Index::Renumber() {
+        for (size_t i = 0; i < slots_.size(); ++i) docs_[slots_[i]].pos = i;
+    }
+
+    void Index::Compact() {
+        std::vector<Doc> docs;
+        docs.reserve(slots_.size());
+        for (uint32_t slot : slots_) docs.push_back(std::move(docs_[slot]));
+        docs_ = std::move(docs);
+        postings_.clear();
+        dead_ = 0;
+        std::vector<uint64_t> grams;
+        for (size_t i = 0; i < docs_.size(); ++i) {
+            slots_[i] = (uint32_t)i;
+            docs_[i].pos = i;
+            Grams(docs_[i].folded, grams);
+            Link((uint32_t)i, grams);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "match.h"
+#include "vault.h"
+
+namespace search {
+    // Trigram postings over the case-folded title, category, username and
+    // url of each entry. Callers mirror every change they make to the
+    // vault's entry list so positions stay in step with it.
+    class Index {
+    public:
+        void Build(const Vault& v);
+        // e was appended to the vault.
+        void Insert(const EntryRef& e);
+        void Update(size_t pos, const EntryRef& e);
+        void Erase(size_t pos);
+
+        // Positions of the entries whose fields contain text, ignoring case,
+        // in vault order.
+        void Query(const std::wstring& text, std::vector<size_t>& out) const;
+
+    private:
+        friend class QuerySession;
+
+        static const int kFields = 4;
+
+        // Per field: where it ends in folded, and a 64-bit set of the
+        // characters in it so fields missing a query character go unscored.
+        struct Doc {
+            std::wstring folded;
+            uint32_t ends[kFields] = {};
+            uint64_t masks[kFields] = {};
+            size_t pos = 0;
+            bool live = true;
+        };
+
+        void Matches(const Pattern& pattern, std::vector<size_t>& out) const;
+        int Score(const Doc& d, const Pattern& pattern, uint64_t need) const;
+        void Link(uint32_t slot, const std::vector<uint64_t>& grams);
+        void Unlink(uint32_t slot, const std::vector<uint64_t>& grams);
+        void Renumber();
+        void Compact();
+
+        std::vector<Doc> docs_;
+        std::vector<uint32_t> slots_;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> postings_;
+        size_t dead_ = 0;
+        // Bumped on every change so sessions know their cache is stale.
+        uint64_t generation_ = 0;
+    };
+
+    // Search-as-you-type over an Index. Remembers what each prefix of the
+    // query matched, so typing a character rescans only the previous
+    // matches and deleting one reuses an earlier result. Reset whenever
+    // accept would start answering differently.
+    class QuerySession {
+    public:
+        void Reset() { steps_.clear(); }
+
+        // Positions of the best k entries accept lets through, best first.
+        void Rank(const Index& index, const std::wstring& text, const std::function<bool(size_t)>& accept,
+            size_t k, std::vector<size_t>& out);
+
+    private:
+        // exact holds the entries containing folded; fuzzy, when hasFuzzy,
+        // those matching it as a subsequence.
+        struct Step {
+            std::wstring folded;
+            std::vector<size_t> exact;
+            std::vector<size_t> fuzzy;
+            bool hasFuzzy = false;
+            std::vector<size_t> ranked;
+        };
+
+        std::vector<Step> steps_;
+        uint64_t generation_ = 0;
+        size_t k_ = 0;
+    };
+}
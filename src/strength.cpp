@@ -0,0 +1,624 @@
+#include "strength.h"
+#include "match.h"
+#include "parallel.h"
+#include "strength_dict.h"
+#include "wordlist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <utility>
+
+namespace {
+    int CurrentYear() {
+        const std::time_t now = std::time(nullptr);
+        const std::tm* utc = std::gmtime(&now);
+        return utc ? utc->tm_year + 1900 : 2026;
+    }
+
+    // Dates are scored by their distance from this year, read once at
+    // startup.
+    const int kReferenceYear = CurrentYear();
+    const int kMinYearSpace = 20;
+    // Fewer entries than this per thread are not worth a thread.
+    const size_t kMinPerThread = 64;
+
+    const double kLog2 = std::log10(2.0);
+
+    // Where zxcvbn cuts 4 to 8 digits into day, month and year: 1/2/34,
+    // 12/3/4 and so on. Unused slots are zero.
+    const int kDateCuts[5][4][2] = {
+        { { 1, 2 }, { 2, 3 } },
+        { { 1, 3 }, { 2, 3 } },
+        { { 1, 2 }, { 2, 4 }, { 4, 5 } },
+        { { 1, 3 }, { 2, 3 }, { 4, 5 }, { 4, 6 } },
+        { { 2, 4 }, { 4, 6 } },
+    };
+
+    // log10(10^a + 10^b).
+    double LogAdd(double a, double b) {
+        const double hi = std::max(a, b);
+        return hi + std::log10(1 + std::pow(10.0, std::min(a, b) - hi));
+    }
+
+    double LogFactorial(int n) {
+        return std::lgamma(n + 1.0) / std::log(10.0);
+    }
+
+    double LogChoose(int n, int k) {
+        return LogFactorial(n) - LogFactorial(k) - LogFactorial(n - k);
+    }
+
+    // log10 of the ways to pick which of a + b characters are the a changed
+    // ones, at most min(a, b) of them, as zxcvbn counts case, l33t and shift
+    // variants.
+    double LogVariants(int a, int b) {
+        double sum = LogChoose(a + b, 1);
+        for (int i = 2; i <= std::min(a, b); ++i) sum = LogAdd(sum, LogChoose(a + b, i));
+        return sum;
+    }
+
+    bool IsLower(wchar_t c) {
+        return (c >= L'a' && c <= L'z') || (c >= 0x430 && c <= 0x44F) || c == 0x451;
+    }
+
+    bool IsUpper(wchar_t c) {
+        return search::Fold(c) != c;
+    }
+
+    // Every dictionary word in one trie, each node's children contiguous
+    // and sorted so a walk from any position finds all the words starting
+    // there in one pass. It is built from the plain word arrays on first
+    // use rather than generated at build time: that takes about 1.5 ms
+    // once, and keeps the lists editable source with no generator step.
+    class Trie {
+    public:
+        struct Node {
+            wchar_t ch = 0;
+            // Guesses for the word ending here, or 0 if none does.
+            uint32_t rank = 0;
+            uint32_t first = 0;
+            uint32_t count = 0;
+        };
+
+        Trie();
+
+        const Node& Root() const { return nodes_[0]; }
+        const Node* Child(const Node& n, wchar_t c) const {
+            const Node* begin = nodes_.data() + n.first;
+            const Node* end = begin + n.count;
+            const Node* it = std::lower_bound(begin, end, c, [](const Node& a, wchar_t b) { return a.ch < b; });
+            return it != end && it->ch == c ? it : nullptr;
+        }
+
+    private:
+        void Add(const wchar_t* word, uint32_t rank);
+        void Build(size_t begin, size_t end, size_t depth, uint32_t node);
+
+        std::vector<std::pair<std::wstring, uint32_t>> words_;
+        std::vector<Node> nodes_;
+    };
+
+    // Key positions on a staggered keyboard: the row above is half a key to
+    // the right, so a key touches two keys above and two below.
+    class Keyboard {
+    public:
+        static const wchar_t kKeyRange = 0x460;
+
+        Keyboard(const wchar_t* const rows[4], const wchar_t* const shifted[4]);
+
+        // 0-5 for the direction from a to its neighbour b, -1 if they are
+        // not neighbours.
+        int Direction(wchar_t a, wchar_t b) const;
+        bool Shifted(wchar_t c) const { return c < kKeyRange && keys_[c].shifted; }
+        // log10 of the guesses for a walk of length keys with turns changes
+        // of direction.
+        double Guesses(int length, int turns) const;
+
+    private:
+        struct Key {
+            signed char row = -1;
+            signed char col = -1;
+            bool shifted = false;
+        };
+
+        Key keys_[kKeyRange];
+        double starts_ = 0;
+        double degree_ = 0;
+    };
+
+    const wchar_t* const kQwerty[4] = { L"`1234567890-=", L"qwertyuiop[]\\", L"asdfghjkl;'", L"zxcvbnm,./" };
+    const wchar_t* const kQwertyShifted[4] = { L"~!@#$%^&*()_+", L"QWERTYUIOP{}|", L"ASDFGHJKL:\"", L"ZXCVBNM<>?" };
+    const wchar_t* const kJcuken[4] = { L"ё1234567890-=", L"йцукенгшщзхъ\\", L"фывапролджэ", L"ячсмитьбю." };
+    const wchar_t* const kJcukenShifted[4] = { L"Ё!\"№;%:?*()_+", L"ЙЦУКЕНГШЩЗХЪ/", L"ФЫВАПРОЛДЖЭ", L"ЯЧСМИТЬБЮ," };
+
+    // Rows after the first start one key in, under the gap after `.
+    int ColumnOf(int row, size_t index) {
+        return (int)index + (row > 0 ? 1 : 0);
+    }
+
+    Keyboard::Keyboard(const wchar_t* const rows[4], const wchar_t* const shifted[4]) {
+        int keys = 0;
+        int links = 0;
+        for (int r = 0; r < 4; ++r) {
+            for (size_t i = 0; rows[r][i]; ++i) {
+                const signed char col = (signed char)ColumnOf(r, i);
+                const wchar_t plain = rows[r][i];
+                const wchar_t shift = shifted[r][i];
+                if (plain < kKeyRange) keys_[plain] = Key{ (signed char)r, col, false };
+                if (shift < kKeyRange) keys_[shift] = Key{ (signed char)r, col, true };
+            }
+        }
+        for (int r = 0; r < 4; ++r) {
+            for (size_t i = 0; rows[r][i]; ++i) {
+                ++keys;
+                for (int s = 0; s < 4; ++s) {
+                    for (size_t j = 0; rows[s][j]; ++j) links += Direction(rows[r][i], rows[s][j]) >= 0;
+                }
+            }
+        }
+        starts_ = keys;
+        degree_ = (double)links / keys;
+    }
+
+    int Keyboard::Direction(wchar_t a, wchar_t b) const {
+        if (a >= kKeyRange || b >= kKeyRange) return -1;
+        const Key& ka = keys_[a];
+        const Key& kb = keys_[b];
+        if (ka.row < 0 || kb.row < 0) return -1;
+        const int dr = kb.row - ka.row;
+        const int dc = kb.col - ka.col;
+        if (dr == 0) return dc == -1 ? 0 : dc == 1 ? 1 : -1;
+        if (dr == -1) return dc == 0 ? 2 : dc == 1 ? 3 : -1;
+        if (dr == 1) return dc == -1 ? 4 : dc == 0 ? 5 : -1;
+        return -1;
+    }
+
+    double Keyboard::Guesses(int length, int turns) const {
+        double sum = 0;
+        for (int i = 2; i <= length; ++i) {
+            for (int j = 1; j <= std::min(turns, i - 1); ++j) {
+                sum += std::pow(10.0, LogChoose(i - 1, j - 1)) * starts_ * std::pow(degree_, j);
+            }
+        }
+        return std::log10(sum);
+    }
+
+    // The QWERTY key in the same place as a lowercase ЙЦУКЕН letter.
+    wchar_t QwertyOf(wchar_t c) {
+        for (int r = 0; r < 4; ++r) {
+            for (size_t i = 0; kJcuken[r][i]; ++i) {
+                if (kJcuken[r][i] == c) return kQwerty[r][i];
+            }
+        }
+        return c;
+    }
+
+    Trie::Trie() {
+        for (size_t i = 0; i < strength::kPasswordCount; ++i) Add(strength::kPasswords[i], (uint32_t)i + 1);
+        for (size_t i = 0; i < strength::kNameCount; ++i) Add(strength::kNames[i], (uint32_t)i + 1);
+        for (size_t i = 0; i < strength::kRussianCount; ++i) {
+            Add(strength::kRussian[i], (uint32_t)i + 1);
+            std::wstring typed = strength::kRussian[i];
+            for (auto& c : typed) c = QwertyOf(c);
+            Add(typed.c_str(), (uint32_t)i + 1);
+        }
+        // Unranked, so every word costs the whole list.
+        for (size_t i = 0; i < passgen::kWordCount; ++i) Add(passgen::kWords[i], (uint32_t)passgen::kWordCount);
+
+        std::sort(words_.begin(), words_.end());
+        nodes_.emplace_back();
+        Build(0, words_.size(), 0, 0);
+        std::vector<std::pair<std::wstring, uint32_t>>().swap(words_);
+    }
+
+    void Trie::Add(const wchar_t* word, uint32_t rank) {
+        std::wstring folded = word;
+        for (auto& c : folded) c = search::Fold(c);
+        words_.emplace_back(std::move(folded), rank);
+    }
+
+    // words_[begin, end) share their first depth characters, the path to
+    // node. Sorting puts the ones ending here first, the best rank leading.
+    void Trie::Build(size_t begin, size_t end, size_t depth, uint32_t node) {
+        while (begin < end && words_[begin].first.size() == depth) {
+            if (nodes_[node].rank == 0) nodes_[node].rank = words_[begin].second;
+            ++begin;
+        }
+        std::vector<std::pair<size_t, size_t>> groups;
+        for (size_t i = begin; i < end;) {
+            size_t j = i + 1;
+            while (j < end && words_[j].first[depth] == words_[i].first[depth]) ++j;
+            groups.emplace_back(i, j);
+            i = j;
+        }
+        const uint32_t first = (uint32_t)nodes_.size();
+        nodes_[node].first = first;
+        nodes_[node].count = (uint32_t)groups.size();
+        nodes_.resize(nodes_.size() + groups.size());
+        for (size_t g = 0; g < groups.size(); ++g) {
+            nodes_[first + g].ch = words_[groups[g].first].first[depth];
+            Build(groups[g].first, groups[g].second, depth + 1, first + (uint32_t)g);
+        }
+    }
+
+    struct Tables {
+        Trie trie;
+        Keyboard qwerty{ kQwerty, kQwertyShifted };
+        Keyboard jcuken{ kJcuken, kJcukenShifted };
+    };
+
+    const Tables& GetTables() {
+        static const Tables tables;
+        return tables;
+    }
+
+    // The letters a l33t character may stand for.
+    int Leet(wchar_t c, wchar_t* out) {
+        switch (c) {
+        case L'4': case L'@': out[0] = L'a'; return 1;
+        case L'8': out[0] = L'b'; return 1;
+        case L'(': case L'{': case L'[': case L'<': out[0] = L'c'; return 1;
+        case L'3': out[0] = L'e'; return 1;
+        case L'6': case L'9': out[0] = L'g'; return 1;
+        case L'1': case L'|': out[0] = L'i'; out[1] = L'l'; return 2;
+        case L'!': out[0] = L'i'; return 1;
+        case L'0': out[0] = L'o'; return 1;
+        case L'$': case L'5': out[0] = L's'; return 1;
+        case L'7': case L'+': out[0] = L't'; return 1;
+        case L'%': out[0] = L'x'; return 1;
+        case L'2': out[0] = L'z'; return 1;
+        default: return 0;
+        }
+    }
+
+    struct Match {
+        int i = 0;
+        int j = 0;
+        // log10 of the guesses.
+        double guesses = 0;
+    };
+
+    double LogGuesses(std::wstring_view p);
+
+    class Matcher {
+    public:
+        Matcher(std::wstring_view raw, std::vector<Match>& out) : raw_(raw), out_(out) {
+            folded_.resize(raw.size());
+            for (size_t i = 0; i < raw.size(); ++i) folded_[i] = search::Fold(raw[i]);
+        }
+
+        void Run() {
+            const int n = (int)raw_.size();
+            Dictionary(folded_, raw_, true, false);
+            std::wstring reversedFolded(folded_.rbegin(), folded_.rend());
+            std::wstring reversedRaw(raw_.rbegin(), raw_.rend());
+            const size_t before = out_.size();
+            Dictionary(reversedFolded, reversedRaw, false, true);
+            for (size_t m = before; m < out_.size(); ++m) {
+                const int i = out_[m].i;
+                out_[m].i = n - 1 - out_[m].j;
+                out_[m].j = n - 1 - i;
+            }
+            Spatial(GetTables().qwerty);
+            Spatial(GetTables().jcuken);
+            Sequence();
+            Repeat();
+            Dates();
+        }
+
+    private:
+        void Dictionary(const std::wstring& folded, std::wstring_view raw, bool leet, bool reversed) {
+            const Trie& trie = GetTables().trie;
+            std::wstring word(folded.size(), L'\0');
+            for (int i = 0; i < (int)folded.size(); ++i) Walk(trie, trie.Root(), folded, raw, i, i, word, leet, reversed);
+        }
+
+        void Walk(const Trie& trie, const Trie::Node& node, const std::wstring& folded, std::wstring_view raw,
+            int start, int pos, std::wstring& word, bool leet, bool reversed) {
+            if (pos == (int)folded.size()) return;
+            wchar_t letters[3] = { folded[pos] };
+            const int count = 1 + (leet ? Leet(folded[pos], letters + 1) : 0);
+            for (int k = 0; k < count; ++k) {
+                const Trie::Node* child = trie.Child(node, letters[k]);
+                if (!child) continue;
+                word[pos - start] = letters[k];
+                if (child->rank) {
+                    const int len = pos - start + 1;
+                    double g = std::log10((double)child->rank) + CaseVariants(raw.substr(start, len));
+                    if (leet) g += LeetVariants(folded.data() + start, word.data(), len);
+                    if (reversed) g += kLog2;
+                    Add(start, pos, g);
+                }
+                Walk(trie, *child, folded, raw, start, pos + 1, word, leet, reversed);
+            }
+        }
+
+        static double CaseVariants(std::wstring_view s) {
+            int upper = 0;
+            int lower = 0;
+            for (wchar_t c : s) {
+                if (IsUpper(c)) ++upper;
+                else if (IsLower(c)) ++lower;
+            }
+            if (upper == 0) return 0;
+            if (lower == 0 || (upper == 1 && (IsUpper(s.front()) || IsUpper(s.back())))) return kLog2;
+            return LogVariants(upper, lower);
+        }
+
+        // For each letter written as l33t somewhere in the match, the ways
+        // to choose which of its occurrences were substituted.
+        static double LeetVariants(const wchar_t* typed, const wchar_t* word, int len) {
+            double sum = 0;
+            for (int t = 0; t < len; ++t) {
+                if (typed[t] == word[t]) continue;
+                const wchar_t letter = word[t];
+                bool seen = false;
+                for (int u = 0; u < t && !seen; ++u) seen = word[u] == letter && typed[u] != letter;
+                if (seen) continue;
+                int subbed = 0;
+                int plain = 0;
+                for (int u = 0; u < len; ++u) {
+                    if (word[u] != letter) continue;
+                    if (typed[u] == letter) ++plain;
+                    else ++subbed;
+                }
+                sum += plain == 0 ? kLog2 : LogVariants(subbed, plain);
+            }
+            return sum;
+        }
+
+        void Spatial(const Keyboard& keys) {
+            const int n = (int)raw_.size();
+            for (int i = 0; i + 2 < n;) {
+                int j = i;
+                int dir = -1;
+                int turns = 0;
+                while (j + 1 < n) {
+                    const int d = keys.Direction(raw_[j], raw_[j + 1]);
+                    if (d < 0) break;
+                    if (d != dir) {
+                        ++turns;
+                        dir = d;
+                    }
+                    ++j;
+                }
+                if (j - i + 1 >= 3) {
+                    int shifted = 0;
+                    for (int k = i; k <= j; ++k) shifted += keys.Shifted(raw_[k]);
+                    const int plain = j - i + 1 - shifted;
+                    double g = keys.Guesses(j - i + 1, turns);
+                    if (shifted > 0) g += plain == 0 ? kLog2 : LogVariants(shifted, plain);
+                    Add(i, j, g);
+                }
+                i = j + 1;
+            }
+        }
+
+        // Runs with a constant step of at most 5 code points: abc, 2468, zyx.
+        void Sequence() {
+            const int n = (int)raw_.size();
+            for (int i = 0; i + 2 < n;) {
+                const int delta = raw_[i + 1] - raw_[i];
+                int j = i + 1;
+                while (j + 1 < n && raw_[j + 1] - raw_[j] == delta) ++j;
+                if (j - i + 1 >= 3 && delta != 0 && std::abs(delta) <= 5) {
+                    const wchar_t c = raw_[i];
+                    double base = 26;
+                    if (std::wstring_view(L"aAzZ019").find(c) != std::wstring_view::npos) base = 4;
+                    else if (c >= L'0' && c <= L'9') base = 10;
+                    else if (c >= 0x410 && c <= 0x451) base = 33;
+                    if (delta < 0) base *= 2;
+                    Add(i, j, std::log10(base * (j - i + 1)));
+                }
+                i = j;
+            }
+        }
+
+        // The longest run of one block repeated from each position: aaa,
+        // abcabc. The block is scored on its own.
+        void Repeat() {
+            const int n = (int)raw_.size();
+            for (int i = 0; i + 1 < n;) {
+                int bestLen = 0;
+                int bestBlock = 0;
+                for (int b = 1; i + 2 * b <= n; ++b) {
+                    int end = i + b;
+                    while (end + b <= n && raw_.compare(i, b, raw_, end, b) == 0) end += b;
+                    if (end - i >= 2 * b && end - i > bestLen) {
+                        bestLen = end - i;
+                        bestBlock = b;
+                    }
+                }
+                if (bestBlock == 0) {
+                    ++i;
+                    continue;
+                }
+                const double block = LogGuesses(raw_.substr(i, bestBlock));
+                Add(i, i + bestLen - 1, block + std::log10((double)(bestLen / bestBlock)));
+                i += bestLen;
+            }
+        }
+
+        static bool IsDigit(wchar_t c) { return c >= L'0' && c <= L'9'; }
+
+        static int Number(std::wstring_view s) {
+            int v = 0;
+            for (wchar_t c : s) v = v * 10 + (c - L'0');
+            return v;
+        }
+
+        // The year of day, month and year in parts, in either d-m-y, m-d-y,
+        // y-m-d or y-d-m order, picking the year nearest the reference; 0 if
+        // they do not make a date.
+        static int DateYear(const std::wstring_view parts[3]) {
+            int best = 0;
+            for (int yearAt = 0; yearAt < 3; yearAt += 2) {
+                const std::wstring_view y = parts[yearAt];
+                if (y.size() == 3) continue;
+                int year = Number(y);
+                if (y.size() == 4) {
+                    if (year < 1000 || year > 2050) continue;
+                } else {
+                    year += year > 50 ? 1900 : 2000;
+                }
+                const std::wstring_view a = parts[yearAt == 0 ? 1 : 0];
+                const std::wstring_view b = parts[yearAt == 0 ? 2 : 1];
+                if (a.size() > 2 || b.size() > 2) continue;
+                const int x = Number(a);
+                const int z = Number(b);
+                const bool dm = x >= 1 && x <= 31 && z >= 1 && z <= 12;
+                const bool md = x >= 1 && x <= 12 && z >= 1 && z <= 31;
+                if (!dm && !md) continue;
+                if (best == 0 || std::abs(year - kReferenceYear) < std::abs(best - kReferenceYear)) best = year;
+            }
+            return best;
+        }
+
+        void Dates() {
+            const int n = (int)raw_.size();
+            for (int i = 0; i < n; ++i) {
+                if (!IsDigit(raw_[i])) continue;
+                // Plain digits: 4 to 8 of them cut where a day, month and
+                // year could meet.
+                int digits = i;
+                while (digits < n && IsDigit(raw_[digits])) ++digits;
+                for (int len = 4; len <= 8 && i + len <= digits; ++len) {
+                    int best = 0;
+                    for (const auto& cut : kDateCuts[len - 4]) {
+                        if (cut[0] == 0) break;
+                        const std::wstring_view parts[3] = { raw_.substr(i, cut[0]), raw_.substr(i + cut[0], cut[1] - cut[0]),
+                            raw_.substr(i + cut[1], len - cut[1]) };
+                        const int year = DateYear(parts);
+                        if (year && (best == 0 || std::abs(year - kReferenceYear) < std::abs(best - kReferenceYear))) best = year;
+                    }
+                    if (best) AddDate(i, i + len - 1, best, false);
+                }
+                if (i + 4 <= digits) {
+                    const int year = Number(raw_.substr(i, 4));
+                    if (year >= 1900 && year <= 2099) AddYear(i, i + 3, year);
+                }
+                // Separated: 1-4 digits, a separator, 1-2 digits, the same
+                // separator, 1-4 digits.
+                for (int a = 1; a <= 4 && i + a < n && IsDigit(raw_[i + a - 1]); ++a) {
+                    const wchar_t sep = raw_[i + a];
+                    if (std::wstring_view(L" -/\\_.").find(sep) == std::wstring_view::npos) continue;
+                    int b = 0;
+                    while (b < 2 && i + a + 1 + b < n && IsDigit(raw_[i + a + 1 + b])) ++b;
+                    if (b == 0 || i + a + 1 + b >= n || raw_[i + a + 1 + b] != sep) continue;
+                    const int third = i + a + b + 2;
+                    for (int c = 1; c <= 4 && third + c <= n && IsDigit(raw_[third + c - 1]); ++c) {
+                        const std::wstring_view parts[3] = { raw_.substr(i, a), raw_.substr(i + a + 1, b),
+                            raw_.substr(third, c) };
+                        const int year = DateYear(parts);
+                        if (year) AddDate(i, third + c - 1, year, true);
+                    }
+                }
+            }
+        }
+
+        static double YearSpace(int year) {
+            return std::max(std::abs(year - kReferenceYear), kMinYearSpace);
+        }
+
+        void AddDate(int i, int j, int year, bool separated) {
+            Add(i, j, std::log10(365 * YearSpace(year) * (separated ? 4 : 1)));
+        }
+
+        void AddYear(int i, int j, int year) {
+            Add(i, j, std::log10(YearSpace(year)));
+        }
+
+        // Matches shorter than the password cost at least 10 guesses for one
+        // character and 50 for more, as in zxcvbn.
+        void Add(int i, int j, double guesses) {
+            if (j - i + 1 < (int)raw_.size()) guesses = std::max(guesses, std::log10(i == j ? 10.0 : 50.0));
+            out_.push_back(Match{ i, j, guesses });
+        }
+
+        std::wstring_view raw_;
+        std::wstring folded_;
+        std::vector<Match>& out_;
+    };
+
+    double BruteForce(int len) {
+        return std::max((double)len, std::log10(len == 1 ? 11.0 : 51.0));
+    }
+
+    // log10 of the guesses for p: the minimum over sequences of l matches
+    // and brute-force gaps covering it of l! * product + 10000^(l-1), the
+    // zxcvbn search. best[k * (n + 1) + l] is the smallest log product of l
+    // pieces covering the first k + 1 characters.
+    double LogGuesses(std::wstring_view p) {
+        const int n = (int)p.size();
+        if (n == 0) return 0;
+        std::vector<Match> matches;
+        Matcher(p, matches).Run();
+        std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) { return a.j < b.j; });
+
+        const double kNone = HUGE_VAL;
+        const int width = n + 1;
+        std::vector<double> best((size_t)n * width, kNone);
+        auto extend = [&](int i, int k, double guesses) {
+            if (i == 0) {
+                best[(size_t)k * width + 1] = std::min(best[(size_t)k * width + 1], guesses);
+                return;
+            }
+            const double* from = &best[(size_t)(i - 1) * width];
+            double* to = &best[(size_t)k * width];
+            for (int l = 1; l <= i; ++l) {
+                if (from[l] != kNone) to[l + 1] = std::min(to[l + 1], from[l] + guesses);
+            }
+        };
+        size_t m = 0;
+        for (int k = 0; k < n; ++k) {
+            for (; m < matches.size() && matches[m].j == k; ++m) extend(matches[m].i, k, matches[m].guesses);
+            for (int i = 0; i <= k; ++i) extend(i, k, BruteForce(k - i + 1));
+        }
+
+        double result = kNone;
+        for (int l = 1; l <= n; ++l) {
+            const double pi = best[(size_t)(n - 1) * width + l];
+            if (pi == kNone) continue;
+            result = std::min(result, LogAdd(LogFactorial(l) + pi, 4.0 * (l - 1)));
+        }
+        return result;
+    }
+}
+
+namespace strength {
+    Estimate Score(std::wstring_view password) {
+        const size_t extra = password.size() > kMaxLength ? password.size() - kMaxLength : 0;
+        const double guesses = LogGuesses(password.substr(0, kMaxLength)) + (double)extra;
+        Estimate e;
+        e.bits = guesses / kLog2;
+        const double thresholds[] = { 1e3 + 5, 1e6 + 5, 1e8 + 5, 1e10 + 5 };
+        while (e.score < 4 && guesses >= std::log10(thresholds[e.score])) ++e.score;
+        return e;
+    }
+
+    bool Score(const crypto::Session& session, const Vault& v, std::vector<Estimate>& out) {
+        const size_t n = v.entries.Size();
+        out.assign(n, Estimate());
+        std::atomic<bool> ok{ true };
+        parallel::ForBlocks(n, kMinPerThread, [&](size_t begin, size_t end) {
+            for (size_t pos = begin; pos < end; ++pos) {
+                Secrets secrets;
+                if (!vault::OpenSecrets(session, v.entries[pos], secrets)) {
+                    ok = false;
+                    continue;
+                }
+                out[pos] = Score(secrets.password);
+            }
+        });
+        return ok;
+    }
+
+    const wchar_t* Label(int score) {
+        static const wchar_t* const kLabels[] = { L"очень слабый", L"слабый", L"средний", L"хороший", L"надёжный" };
+        return kLabels[std::max(0, std::min(score, 4))];
+    }
+}
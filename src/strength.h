@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "crypto.h"
+#include "vault.h"
+
+namespace strength {
+    // How many guesses an attacker who knows the usual patterns needs, in
+    // bits, and the zxcvbn score for it: 0 under 10^3 guesses, then 10^6,
+    // 10^8 and 10^10, and 4 above.
+    struct Estimate {
+        double bits = 0;
+        int score = 0;
+    };
+
+    // zxcvbn-style estimate: the password is covered by the cheapest run of
+    // dictionary words (ranked, reversed, l33t and case variants), keyboard
+    // walks on QWERTY and ЙЦУКЕН, sequences, repeats, dates and years, with
+    // brute force for the gaps. Only the first kMaxLength characters are
+    // matched; the rest count as brute force.
+    const size_t kMaxLength = 64;
+    Estimate Score(std::wstring_view password);
+
+    // Scores the password of every entry, by position, splitting the vault
+    // across threads. False if any entry's secrets fail to open; those score
+    // as empty.
+    bool Score(const crypto::Session& session, const Vault& v, std::vector<Estimate>& out);
+
+    // "очень слабый" to "надёжный".
+    const wchar_t* Label(int score);
+}
@@ -0,0 +1,86 @@
+#include "strength_dict.h"
+
+namespace strength {
+    const wchar_t* const kPasswords[] = {
+        L"123456", L"password", L"123456789", L"12345678", L"12345", L"qwerty", L"1234567", L"111111",
+        L"1234567890", L"123123", L"abc123", L"1234", L"password1", L"iloveyou", L"1q2w3e4r", L"000000",
+        L"qwerty123", L"zaq12wsx", L"dragon", L"sunshine", L"princess", L"letmein", L"654321", L"monkey",
+        L"27653", L"1qaz2wsx", L"123321", L"qwertyuiop", L"superman", L"asdfghjkl", L"football", L"baseball",
+        L"welcome", L"master", L"shadow", L"michael", L"666666", L"jesus", L"121212", L"trustno1",
+        L"123qwe", L"1q2w3e", L"1qaz2wsx3edc", L"qazwsx", L"7777777", L"555555", L"987654321", L"112233",
+        L"hello", L"freedom", L"whatever", L"qwerty1", L"ashley", L"charlie", L"aa123456", L"donald",
+        L"password123", L"loveme", L"888888", L"mustang", L"access", L"batman", L"starwars", L"696969",
+        L"solo", L"hottie", L"flower", L"passw0rd", L"1234qwer", L"zxcvbnm", L"zxcvbn", L"asdfgh",
+        L"asdf", L"11111111", L"12341234", L"1111", L"0000", L"2000", L"admin", L"administrator",
+        L"root", L"login", L"guest", L"test", L"test123", L"changeme", L"secret", L"default",
+        L"hunter", L"ranger", L"buster", L"soccer", L"hockey", L"killer", L"george", L"andrew",
+        L"joshua", L"pepper", L"daniel", L"thomas", L"jordan", L"harley", L"robert", L"matthew",
+        L"jennifer", L"hunter2", L"computer", L"internet", L"tigger", L"cookie", L"summer", L"winter",
+        L"spring", L"autumn", L"orange", L"purple", L"yellow", L"silver", L"golden", L"diamond",
+        L"angel", L"angels", L"baby", L"babygirl", L"lovely", L"love", L"lover", L"loveyou",
+        L"family", L"friends", L"friend", L"forever", L"iloveu", L"mylove", L"sweet", L"sweetie",
+        L"honey", L"sugar", L"chocolate", L"banana", L"apple", L"cherry", L"peanut", L"butter",
+        L"coffee", L"pizza", L"cheese", L"dolphin", L"tiger", L"lion", L"bear", L"eagle",
+        L"falcon", L"wolf", L"shark", L"snake", L"horse", L"maggie", L"ginger", L"buddy",
+        L"bailey", L"lucky", L"molly", L"sophie", L"chicken", L"rabbit", L"letmein1", L"welcome1",
+        L"qwerty12", L"abcd1234", L"abc12345", L"a123456", L"q1w2e3r4", L"1qazxsw2", L"qweasd", L"qweasdzxc",
+        L"qazxsw", L"asdasd", L"zxczxc", L"qweqwe", L"123abc", L"abcdef", L"abcabc", L"147258369",
+        L"147258", L"159753", L"159357", L"753951", L"456789", L"789456", L"135790", L"246810",
+        L"101010", L"131313", L"202020", L"232323", L"252525", L"292929", L"123654", L"102030",
+        L"010203", L"090909", L"999999", L"777777", L"444444", L"333333", L"222222", L"11111",
+        L"12345a", L"123456a", L"1234abcd", L"pass", L"pass123", L"password12", L"password01", L"p@ssw0rd",
+        L"p@ssword", L"pa55word", L"passwd", L"letmein123", L"iloveyou1", L"princess1", L"monkey1", L"dragon1",
+        L"sunshine1", L"football1", L"shadow1", L"matrix", L"merlin", L"phoenix", L"samsung", L"nintendo",
+        L"pokemon", L"naruto", L"minecraft", L"warcraft", L"starcraft", L"gamer", L"player", L"gaming",
+        L"google", L"yahoo", L"facebook", L"twitter", L"myspace", L"liverpool", L"chelsea", L"arsenal",
+        L"barcelona", L"realmadrid", L"juventus", L"manchester", L"united", L"ferrari", L"porsche", L"mercedes",
+        L"corvette", L"yamaha", L"honda", L"toyota", L"jordan23", L"michael1", L"charlie1", L"thomas1",
+        L"daniel1", L"robert1", L"jessica", L"ashley1", L"nicole", L"amanda", L"hannah", L"jasmine",
+        L"samantha", L"melissa", L"michelle", L"elizabeth", L"qwertyu", L"qwerty1234", L"1q2w3e4r5t", L"1q2w3e4r5t6y",
+        L"zaq1zaq1", L"zaq1xsw2", L"!qaz2wsx", L"q1w2e3", L"1z2x3c", L"1a2s3d", L"123qweasd", L"qwe123",
+        L"asd123", L"zxc123", L"qaz123", L"blink182", L"metallica", L"nirvana", L"slipknot", L"eminem",
+        L"rockstar", L"rocknroll", L"music", L"hello123", L"hello1", L"welcome123", L"admin123", L"root123",
+        L"test1", L"test1234", L"user", L"princesa", L"teamo", L"contraseña", L"tequiero", L"5201314",
+        L"woaini", L"iloveyou2", L"trustme", L"believe", L"destiny", L"heaven", L"angel1", L"jesus1",
+        L"christ", L"blessed", L"faith"
+    };
+    const size_t kPasswordCount = sizeof(kPasswords) / sizeof(kPasswords[0]);
+
+    const wchar_t* const kNames[] = {
+        L"michael", L"jennifer", L"david", L"jessica", L"james", L"ashley", L"robert", L"sarah",
+        L"john", L"amanda", L"daniel", L"emily", L"matthew", L"elizabeth", L"andrew", L"nicole",
+        L"joseph", L"melissa", L"william", L"stephanie", L"christopher", L"rachel", L"joshua", L"heather",
+        L"ryan", L"lauren", L"brandon", L"rebecca", L"anthony", L"megan", L"thomas", L"amber",
+        L"justin", L"kimberly", L"kevin", L"laura", L"eric", L"anna", L"alex", L"maria",
+        L"max", L"ben", L"sam", L"tom", L"jack", L"oliver", L"harry", L"charlie",
+        L"george", L"emma", L"olivia", L"sophia", L"mia", L"isabella", L"ava", L"chloe",
+        L"lily", L"grace", L"ella", L"lucy", L"alice", L"kate", L"linda", L"alexander",
+        L"alexey", L"alexandr", L"alexandra", L"aleksandr", L"aleksey", L"andrey", L"andrei", L"anton",
+        L"artem", L"boris", L"denis", L"dmitry", L"dmitriy", L"dima", L"evgeny", L"evgeniy",
+        L"igor", L"ilya", L"ivan", L"kirill", L"konstantin", L"maksim", L"maxim", L"mikhail",
+        L"misha", L"nikita", L"nikolay", L"oleg", L"pavel", L"roman", L"ruslan", L"sergey",
+        L"sergei", L"stanislav", L"vadim", L"valentin", L"viktor", L"vitaly", L"vladimir", L"vladislav",
+        L"yuri", L"yura", L"sasha", L"vova", L"kolya", L"petya", L"vanya", L"lesha",
+        L"tolya", L"anastasia", L"nastya", L"natasha", L"natalia", L"natalya", L"olga", L"irina",
+        L"ekaterina", L"katya", L"tatiana", L"tanya", L"svetlana", L"sveta", L"marina", L"elena",
+        L"lena", L"yulia", L"julia", L"ksenia", L"kristina", L"alina", L"polina", L"daria",
+        L"dasha", L"victoria", L"vika", L"valeria", L"lera", L"sofia"
+    };
+    const size_t kNameCount = sizeof(kNames) / sizeof(kNames[0]);
+
+    const wchar_t* const kRussian[] = {
+        L"пароль", L"привет", L"любовь", L"люблю", L"солнце", L"солнышко", L"котик", L"кошка",
+        L"собака", L"зайка", L"москва", L"россия", L"родина", L"мама", L"папа", L"семья",
+        L"дружба", L"счастье", L"жизнь", L"мир", L"весна", L"лето", L"осень", L"зима",
+        L"небо", L"море", L"звезда", L"ангел", L"красота", L"доброе", L"наташа", L"маша",
+        L"саша", L"катя", L"оля", L"лена", L"таня", L"света", L"ира", L"юля",
+        L"андрей", L"сергей", L"дмитрий", L"алексей", L"владимир", L"максим", L"никита", L"иван",
+        L"михаил", L"артем", L"спартак", L"зенит", L"динамо", L"цска", L"локомотив", L"футбол",
+        L"хоккей", L"музыка", L"игра", L"танк", L"компьютер", L"интернет", L"админ", L"логин",
+        L"вход", L"пароль123", L"йцукен", L"фыва", L"ячсмит", L"цветок", L"мышка", L"рыбка",
+        L"птичка", L"малыш", L"малышка", L"принцесса", L"королева", L"король", L"бог", L"вера",
+        L"надежда", L"победа", L"свобода", L"сила", L"удача", L"деньги", L"работа", L"школа",
+        L"дом", L"друг"
+    };
+    const size_t kRussianCount = sizeof(kRussian) / sizeof(kRussian[0]);
+}
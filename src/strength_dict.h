@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+namespace strength {
+    // Ranked lists for the estimator, most common first, in lowercase. A
+    // word's rank is the number of guesses it takes; the BIP-39 list in
+    // wordlist.h supplies common English words on top of these.
+    extern const size_t kPasswordCount;
+    extern const wchar_t* const kPasswords[];
+    extern const size_t kNameCount;
+    extern const wchar_t* const kNames[];
+    // Common Russian words; each is also looked up as typed with the layout
+    // left on QWERTY, so пароль matches gfhjkm.
+    extern const size_t kRussianCount;
+    extern const wchar_t* const kRussian[];
+}
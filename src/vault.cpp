@@ -1,22 +1,29 @@
 #include "vault.h"
+#include "codec.h"
 #include "crypto.h"
+#include "mapped_file.h"
 
 #include <windows.h>
 #include <shlobj.h>
-#include <fstream>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
 
 namespace {
-    std::wstring Escape(const std::wstring& s) {
-        std::wstring out;
-        out.reserve(s.size());
-        for (wchar_t c : s) {
-            if (c == L'\\' || c == L'\t' || c == L'\n') out.push_back(L'\\');
-            if (c == L'\t') out.push_back(L't');
-            else if (c == L'\n') out.push_back(L'n');
-            else out.push_back(c);
-        }
-        return out;
-    }
+    const unsigned char kJournalMagic[4] = { 'L', 'S', 'K', 'J' };
+    const ULONG kJournalVersion = 2;
+    const ULONG kJournalVersionVaultKey = 1;
+    const size_t kJournalHeaderLen = 8 + crypto::Key::kTagSize;
+    const size_t kRecordOverhead = crypto::Key::kNonceSize + crypto::Key::kTagSize;
+    const uint64_t kMinCompactBytes = 256 * 1024;
+    const unsigned char kOpPut = 0x01;
+    const unsigned char kOpRemove = 0x02;
+    const unsigned char kSecretsFormat = 0x00;
+    // Text journal ops written before the binary codec.
+    const wchar_t kTextOpPutLegacy = L'P';
+    const wchar_t kTextOpPut = L'S';
+    const wchar_t kTextOpRemove = L'D';
+    const wchar_t kFormatTag[] = L"@v2";
 
     std::wstring Unescape(const std::wstring& s) {
         std::wstring out;
@@ -39,14 +46,6 @@ namespace {
         return out;
     }
 
-    std::vector<unsigned char> ToUtf8(const std::wstring& w) {
-        if (w.empty()) return {};
-        int len = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), nullptr, 0, nullptr, nullptr);
-        std::vector<unsigned char> out(len);
-        WideCharToMultiByte(CP_UTF8, 0, w.c_str(), (int)w.size(), (LPSTR)out.data(), len, nullptr, nullptr);
-        return out;
-    }
-
     std::wstring FromUtf8(const std::vector<unsigned char>& data) {
         if (data.empty()) return L"";
         int len = MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)data.data(), (int)data.size(), nullptr, 0);
@@ -55,88 +54,396 @@ namespace {
         return out;
     }
 
-    std::vector<unsigned char> Serialize(const Vault& v) {
-        std::wstring text;
-        for (const auto& e : v.entries) {
-            text += Escape(e.title) + L"\t" +
-                Escape(e.category) + L"\t" +
-                Escape(e.username) + L"\t" +
-                Escape(e.password) + L"\t" +
-                Escape(e.url) + L"\t" +
-                Escape(e.notes) + L"\n";
+    void ZeroText(std::wstring& text) {
+        crypto::SecureZero(&text[0], text.size() * sizeof(wchar_t));
+    }
+
+    bool FromHex(const wchar_t* s, size_t len, std::vector<unsigned char>& out) {
+        auto nibble = [](wchar_t c) -> int {
+            if (c >= L'0' && c <= L'9') return c - L'0';
+            if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+            return -1;
+        };
+        if (len % 2 != 0) return false;
+        out.resize(len / 2);
+        for (size_t i = 0; i < out.size(); ++i) {
+            int hi = nibble(s[2 * i]);
+            int lo = nibble(s[2 * i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            out[i] = (unsigned char)((hi << 4) | lo);
         }
-        return ToUtf8(text);
+        return true;
     }
 
-    Vault Deserialize(const std::vector<unsigned char>& bytes) {
-        Vault v;
+    std::vector<std::wstring> SplitFields(const std::wstring& line) {
+        std::vector<std::wstring> out;
+        size_t start = 0;
+        while (true) {
+            size_t tab = line.find(L'\t', start);
+            if (tab == std::wstring::npos) {
+                out.push_back(line.substr(start));
+                return out;
+            }
+            out.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+    }
+
+    // Text layout used before the binary codec:
+    // title, category, username, url, id, sealed secrets (hex)
+    bool ParseLine(const std::wstring& line, Entry& e) {
+        std::vector<std::wstring> f = SplitFields(line);
+        if (f.size() != 6) return false;
+        e.title = Unescape(f[0]);
+        e.category = Unescape(f[1]);
+        e.username = Unescape(f[2]);
+        e.url = Unescape(f[3]);
+        e.id = wcstoull(f[4].c_str(), nullptr, 10);
+        return FromHex(f[5].c_str(), f[5].size(), e.secrets);
+    }
+
+    // Plaintext layouts from before secrets were sealed per entry: the
+    // original 5- and 6-field lines and the 7-field line that added ids.
+    bool ParseLegacyLine(const std::wstring& line, Entry& e, Secrets& s) {
+        if (line.empty()) return false;
+        size_t p1 = line.find(L'\t');
+        size_t p2 = line.find(L'\t', p1 == std::wstring::npos ? line.size() : p1 + 1);
+        size_t p3 = line.find(L'\t', p2 == std::wstring::npos ? line.size() : p2 + 1);
+        size_t p4 = line.find(L'\t', p3 == std::wstring::npos ? line.size() : p3 + 1);
+        size_t p5 = line.find(L'\t', p4 == std::wstring::npos ? line.size() : p4 + 1);
+        size_t p6 = line.find(L'\t', p5 == std::wstring::npos ? line.size() : p5 + 1);
+        if (p1 != std::wstring::npos) e.title = Unescape(line.substr(0, p1));
+        if (p2 != std::wstring::npos) e.category = Unescape(line.substr(p1 + 1, p2 - p1 - 1));
+        if (p3 != std::wstring::npos) e.username = Unescape(line.substr(p2 + 1, p3 - p2 - 1));
+        if (p4 != std::wstring::npos) s.password = Unescape(line.substr(p3 + 1, p4 - p3 - 1));
+        if (p6 != std::wstring::npos) {
+            e.url = Unescape(line.substr(p4 + 1, p5 - p4 - 1));
+            s.notes = Unescape(line.substr(p5 + 1, p6 - p5 - 1));
+            e.id = wcstoull(line.c_str() + p6 + 1, nullptr, 10);
+        } else if (p5 != std::wstring::npos) {
+            e.url = Unescape(line.substr(p4 + 1, p5 - p4 - 1));
+            s.notes = Unescape(line.substr(p5 + 1));
+        } else if (p4 != std::wstring::npos) {
+            // Backward compatibility with older 5-field format
+            e.url = Unescape(line.substr(p3 + 1, p4 - p3 - 1));
+            s.notes = Unescape(line.substr(p4 + 1));
+        }
+        return true;
+    }
+
+    // Entries from files written before ids existed get numbered after the
+    // highest id already present.
+    void AssignIds(Vault& v) {
+        uint64_t next = v.nextId;
+        const size_t count = v.entries.Size();
+        for (size_t i = 0; i < count; ++i) next = std::max(next, v.entries.Id(i) + 1);
+        for (size_t i = 0; i < count; ++i) {
+            if (v.entries.Id(i) == 0) v.entries.SetId(i, next++);
+        }
+        v.nextId = next;
+    }
+
+    void SecretAad(uint64_t id, unsigned char* aad) {
+        for (int i = 0; i < 8; ++i) aad[i] = (unsigned char)(id >> (8 * i));
+    }
+
+    // Text checkpoints: an "@v2" first line carrying the wrapped records key,
+    // or the older layouts that hold secrets in the clear. Those get a fresh
+    // records key and are sealed on the way in.
+    bool DeserializeText(crypto::Session& session, const std::vector<unsigned char>& bytes, Vault& v) {
         std::wstring text = FromUtf8(bytes);
         size_t start = 0;
+        size_t end = text.find(L'\n');
+        if (end == std::wstring::npos) end = text.size();
+        std::wstring first = text.substr(0, end);
+        const size_t tagLen = wcslen(kFormatTag);
+        bool current = first.compare(0, tagLen, kFormatTag) == 0 && first.size() > tagLen && first[tagLen] == L'\t';
+
+        std::vector<std::pair<size_t, std::unique_ptr<Secrets>>> legacy;
+        if (current) {
+            std::vector<unsigned char> wrapped;
+            if (!FromHex(first.c_str() + tagLen + 1, first.size() - tagLen - 1, wrapped)) return false;
+            if (!session.LoadRecordKey(wrapped)) return false;
+            start = end + 1;
+        } else if (!session.NewRecordKey()) {
+            return false;
+        }
+
         while (start < text.size()) {
-            size_t end = text.find(L'\n', start);
+            end = text.find(L'\n', start);
             if (end == std::wstring::npos) end = text.size();
             std::wstring line = text.substr(start, end - start);
-            if (!line.empty()) {
-                Entry e;
-                size_t p1 = line.find(L'\t');
-                size_t p2 = line.find(L'\t', p1 == std::wstring::npos ? line.size() : p1 + 1);
-                size_t p3 = line.find(L'\t', p2 == std::wstring::npos ? line.size() : p2 + 1);
-                size_t p4 = line.find(L'\t', p3 == std::wstring::npos ? line.size() : p3 + 1);
-                size_t p5 = line.find(L'\t', p4 == std::wstring::npos ? line.size() : p4 + 1);
-                if (p1 != std::wstring::npos) e.title = Unescape(line.substr(0, p1));
-                if (p2 != std::wstring::npos) e.category = Unescape(line.substr(p1 + 1, p2 - p1 - 1));
-                if (p3 != std::wstring::npos) e.username = Unescape(line.substr(p2 + 1, p3 - p2 - 1));
-                if (p4 != std::wstring::npos) e.password = Unescape(line.substr(p3 + 1, p4 - p3 - 1));
-                if (p5 != std::wstring::npos) {
-                    e.url = Unescape(line.substr(p4 + 1, p5 - p4 - 1));
-                    e.notes = Unescape(line.substr(p5 + 1));
-                } else if (p4 != std::wstring::npos) {
-                    // Backward compatibility with older 5-field format
-                    e.url = Unescape(line.substr(p3 + 1, p4 - p3 - 1));
-                    e.notes = Unescape(line.substr(p4 + 1));
+            Entry e;
+            if (current) {
+                if (ParseLine(line, e)) v.entries.Append(e);
+            } else {
+                std::unique_ptr<Secrets> secrets(new Secrets());
+                if (ParseLegacyLine(line, e, *secrets)) {
+                    legacy.emplace_back(v.entries.Size(), std::move(secrets));
+                    v.entries.Append(e);
                 }
-                v.entries.push_back(e);
             }
+            ZeroText(line);
             start = end + 1;
         }
-        return v;
+        ZeroText(text);
+        AssignIds(v);
+        Entry e;
+        for (auto& l : legacy) {
+            v.entries.Load(l.first, e);
+            if (!vault::SealSecrets(session, e, *l.second)) return false;
+            v.entries.Replace(l.first, e);
+        }
+        return true;
     }
 
-    bool ReadFile(const std::wstring& path, std::vector<unsigned char>& out) {
-        HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    // Entries are parsed as views over the decrypted checkpoint, decoded
+    // into one reused scratch entry and copied into the table's arenas,
+    // sized up front from the encoded lengths. Text checkpoints set
+    // migrated so the caller rewrites them in the binary layout.
+    bool Deserialize(crypto::Session& session, const std::vector<unsigned char>& bytes, Vault& v, bool& migrated) {
+        if (!codec::IsVault(bytes.data(), bytes.size())) {
+            migrated = true;
+            return DeserializeText(session, bytes, v);
+        }
+        codec::Bytes wrapped;
+        std::vector<codec::EntryView> views;
+        if (!codec::ReadVault(bytes.data(), bytes.size(), wrapped, views)) return false;
+        if (!session.LoadRecordKey(std::vector<unsigned char>(wrapped.data, wrapped.data + wrapped.size))) return false;
+        // A UTF-8 byte never decodes to more than one UTF-16 unit.
+        size_t chars = 0;
+        size_t sealed = 0;
+        for (const auto& view : views) {
+            chars += view.title.size + view.category.size + view.username.size + view.url.size;
+            sealed += view.secrets.size;
+        }
+        v.entries.Clear();
+        v.entries.Reserve(views.size(), chars, sealed);
+        Entry e;
+        for (const auto& view : views) {
+            if (!codec::Materialize(view, e)) return false;
+            v.entries.Append(e);
+        }
+        AssignIds(v);
+        migrated = false;
+        return true;
+    }
+
+    bool WriteAll(HANDLE h, const std::vector<unsigned char>& data) {
+        size_t off = 0;
+        while (off < data.size()) {
+            DWORD written = 0;
+            DWORD chunk = (DWORD)std::min<size_t>(data.size() - off, 1u << 30);
+            if (!::WriteFile(h, data.data() + off, chunk, &written, nullptr) || written == 0) return false;
+            off += written;
+        }
+        return true;
+    }
+
+    bool WriteDurable(const std::wstring& path, const std::vector<unsigned char>& data) {
+        HANDLE h = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
         if (h == INVALID_HANDLE_VALUE) return false;
-        LARGE_INTEGER size{};
-        if (!GetFileSizeEx(h, &size)) {
-            CloseHandle(h);
+        bool ok = WriteAll(h, data) && FlushFileBuffers(h);
+        CloseHandle(h);
+        return ok;
+    }
+
+    bool Replace(const std::wstring& from, const std::wstring& to) {
+        return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+    }
+
+    // Writes data at offset and cuts the file there, so a torn record left by
+    // a crash is overwritten by the next append.
+    bool WriteAt(const std::wstring& path, uint64_t offset, const std::vector<unsigned char>& data) {
+        HANDLE h = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER pos{};
+        pos.QuadPart = (LONGLONG)offset;
+        DWORD written = 0;
+        BOOL ok = SetFilePointerEx(h, pos, nullptr, FILE_BEGIN) &&
+            ::WriteFile(h, data.data(), (DWORD)data.size(), &written, nullptr) &&
+            written == data.size() &&
+            SetEndOfFile(h) &&
+            FlushFileBuffers(h);
+        CloseHandle(h);
+        return ok != FALSE;
+    }
+
+    void PutU32(unsigned char* p, ULONG v) {
+        for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+    }
+
+    ULONG GetU32(const unsigned char* p) {
+        return (ULONG)p[0] | ((ULONG)p[1] << 8) | ((ULONG)p[2] << 16) | ((ULONG)p[3] << 24);
+    }
+
+    std::vector<unsigned char> JournalHeader(const unsigned char* tag) {
+        std::vector<unsigned char> h(kJournalHeaderLen);
+        memcpy(h.data(), kJournalMagic, 4);
+        PutU32(h.data() + 4, kJournalVersion);
+        memcpy(h.data() + 8, tag, crypto::Key::kTagSize);
+        return h;
+    }
+
+    // Version 1 journals are still read; header takes the journal's version.
+    bool JournalMatches(const MappedFile& journal, std::vector<unsigned char>& header) {
+        if (journal.Size() < kJournalHeaderLen) return false;
+        const ULONG version = GetU32(journal.Data() + 4);
+        if (version != kJournalVersion && version != kJournalVersionVaultKey) return false;
+        if (memcmp(journal.Data(), header.data(), 4) != 0 ||
+            memcmp(journal.Data() + 8, header.data() + 8, crypto::Key::kTagSize) != 0) {
             return false;
         }
-        if (size.QuadPart < 0) {
-            CloseHandle(h);
-            return false;
+        PutU32(header.data() + 4, version);
+        return true;
+    }
+
+    // Records used to be sealed under the vault key, which a password change
+    // or KDF upgrade replaces; now they use the records key, which survives it.
+    const crypto::Key& JournalKey(const crypto::Session& session, const std::vector<unsigned char>& header) {
+        return GetU32(header.data() + 4) == kJournalVersionVaultKey ? session.VaultKey() : session.RecordKey();
+    }
+
+    // Associated data binds each record to its checkpoint and position, so
+    // records cannot be replayed against another checkpoint or reordered.
+    void RecordAad(const std::vector<unsigned char>& header, uint64_t seq, unsigned char* aad) {
+        memcpy(aad, header.data(), kJournalHeaderLen);
+        for (int i = 0; i < 8; ++i) aad[kJournalHeaderLen + i] = (unsigned char)(seq >> (8 * i));
+    }
+
+    bool SealRecord(const crypto::Session& session, const std::vector<unsigned char>& header, uint64_t seq,
+        const std::vector<unsigned char>& record, std::vector<unsigned char>& out) {
+        unsigned char aad[kJournalHeaderLen + 8];
+        RecordAad(header, seq, aad);
+        size_t base = out.size();
+        out.resize(base + 4 + kRecordOverhead + record.size());
+        unsigned char* frame = out.data() + base;
+        PutU32(frame, (ULONG)(kRecordOverhead + record.size()));
+        unsigned char* nonce = frame + 4;
+        unsigned char* tag = nonce + crypto::Key::kNonceSize;
+        if (!crypto::Engine::Get().Random(nonce, crypto::Key::kNonceSize)) return false;
+        return JournalKey(session, header).Encrypt(nonce, aad, sizeof(aad),
+            record.data(), record.size(), tag + crypto::Key::kTagSize, tag);
+    }
+
+    struct Replay {
+        const crypto::Session& session;
+        Vault& vault;
+        std::unordered_map<uint64_t, size_t> index;
+        std::vector<bool> removed;
+        bool migrated = false;
+
+        Replay(const crypto::Session& s, Vault& v) : session(s), vault(v), removed(v.entries.Size(), false) {
+            for (size_t i = 0; i < v.entries.Size(); ++i) index[v.entries.Id(i)] = i;
+        }
+
+        void Put(Entry& e) {
+            auto it = index.find(e.id);
+            if (it != index.end()) {
+                vault.entries.Replace(it->second, e);
+            } else {
+                index[e.id] = vault.entries.Size();
+                vault.entries.Append(e);
+                removed.push_back(false);
+            }
         }
-        out.resize((size_t)size.QuadPart);
-        DWORD read = 0;
-        BOOL ok = TRUE;
-        if (!out.empty()) {
-            ok = ::ReadFile(h, out.data(), (DWORD)out.size(), &read, nullptr);
+
+        void Erase(uint64_t id) {
+            auto it = index.find(id);
+            if (it != index.end()) {
+                removed[it->second] = true;
+                index.erase(it);
+            }
         }
-        CloseHandle(h);
-        return ok && read == out.size();
+
+        void Apply(const std::vector<unsigned char>& record) {
+            if (record.empty()) return;
+            codec::Reader r(record.data() + 1, record.size() - 1);
+            if (record[0] == kOpPut) {
+                codec::EntryView view;
+                Entry e;
+                if (codec::ReadEntry(r, view) && view.id != 0 && codec::Materialize(view, e)) Put(e);
+            } else if (record[0] == kOpRemove) {
+                uint64_t id = 0;
+                if (r.U64(id)) Erase(id);
+            } else {
+                ApplyText(record);
+            }
+        }
+
+        // Journals written before the binary codec; their records are folded
+        // into a binary checkpoint once replayed.
+        void ApplyText(const std::vector<unsigned char>& record) {
+            std::wstring text = FromUtf8(record);
+            if (text.empty()) return;
+            migrated = true;
+            if (text[0] == kTextOpPut) {
+                Entry e;
+                if (ParseLine(text.substr(1), e) && e.id != 0) Put(e);
+            } else if (text[0] == kTextOpPutLegacy) {
+                Entry e;
+                Secrets secrets;
+                std::wstring line = text.substr(1);
+                if (ParseLegacyLine(line, e, secrets) && e.id != 0 && vault::SealSecrets(session, e, secrets)) {
+                    Put(e);
+                }
+                ZeroText(line);
+            } else if (text[0] == kTextOpRemove) {
+                Erase(wcstoull(text.c_str() + 1, nullptr, 10));
+            }
+            ZeroText(text);
+        }
+
+        void Finish() {
+            vault.entries.Erase(removed);
+            AssignIds(vault);
+        }
+    };
+
+    bool SealAndWrite(HANDLE h, crypto::SealStream& stream, std::vector<unsigned char>& plain,
+        std::vector<unsigned char>& sealed, bool final, uint64_t& size) {
+        bool ok = stream.Update(plain.data(), plain.size(), sealed) && (!final || stream.Finish(sealed));
+        crypto::SecureZero(plain.data(), plain.size());
+        plain.clear();
+        ok = ok && WriteAll(h, sealed);
+        size += sealed.size();
+        sealed.clear();
+        return ok;
     }
 
-    bool WriteFile(const std::wstring& path, const std::vector<unsigned char>& data) {
+    // Serializes, seals and writes the checkpoint a chunk at a time, so
+    // memory stays bounded by the chunk size plus the largest entry. plain
+    // is a scratch buffer kept across checkpoints; it is zeroed after each
+    // chunk but keeps its capacity.
+    bool WriteCheckpoint(const crypto::Session& session, const Vault& in, const std::wstring& path,
+        std::vector<unsigned char>& plain, unsigned char* tag, uint64_t& size) {
         HANDLE h = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
         if (h == INVALID_HANDLE_VALUE) return false;
-        DWORD written = 0;
-        BOOL ok = TRUE;
-        if (!data.empty()) {
-            ok = ::WriteFile(h, data.data(), (DWORD)data.size(), &written, nullptr);
+        crypto::SealStream stream;
+        std::vector<unsigned char> sealed;
+        sealed.reserve(2 * crypto::SealStream::kChunkSize);
+        plain.clear();
+        codec::WriteVaultHeader(session.WrappedRecordKey(), in.entries.Size(), plain);
+        codec::Writer w(plain);
+        size = 0;
+        bool ok = stream.Begin(session, sealed);
+        for (size_t i = 0; ok && i < in.entries.Size(); ++i) {
+            codec::WriteEntry(w, in.entries[i]);
+            if (plain.size() >= crypto::SealStream::kChunkSize) ok = SealAndWrite(h, stream, plain, sealed, false, size);
         }
+        ok = ok && SealAndWrite(h, stream, plain, sealed, true, size) && FlushFileBuffers(h);
         CloseHandle(h);
-        return ok && written == data.size();
+        crypto::SecureZero(plain.data(), plain.size());
+        if (ok) memcpy(tag, stream.Tag(), crypto::Key::kTagSize);
+        return ok;
     }
 }
 
+Secrets::~Secrets() {
+    crypto::SecureZero(&password[0], password.size() * sizeof(wchar_t));
+    crypto::SecureZero(&notes[0], notes.size() * sizeof(wchar_t));
+}
+
 namespace vault {
     std::wstring VaultPath() {
         wchar_t folder[MAX_PATH];
@@ -146,19 +453,310 @@ namespace vault {
         return dir + L"\\vault.dat";
     }
 
-    bool Load(const std::wstring& password, Vault& out) {
-        std::vector<unsigned char> blob;
-        if (!ReadFile(VaultPath(), blob)) return false;
+    // The format byte, password, notes and the u64 change time; records
+    // sealed before the change time end after the notes. Reserved for the
+    // worst-case UTF-8 size up front so the plaintext is never reallocated,
+    // which would leave unzeroed copies on the heap.
+    bool SealSecrets(const crypto::Session& session, Entry& e, const Secrets& in) {
+        std::vector<unsigned char> plain;
+        plain.reserve(17 + 4 * (in.password.size() + in.notes.size()));
+        codec::Writer w(plain);
+        w.U8(kSecretsFormat);
+        w.Text(in.password);
+        w.Text(in.notes);
+        w.U64(in.changed);
+        unsigned char aad[8];
+        SecretAad(e.id, aad);
+        std::vector<unsigned char> sealed(crypto::Key::kNonceSize + crypto::Key::kTagSize + plain.size());
+        unsigned char* nonce = sealed.data();
+        unsigned char* tag = nonce + crypto::Key::kNonceSize;
+        bool ok = crypto::Engine::Get().Random(nonce, crypto::Key::kNonceSize) &&
+            session.RecordKey().Encrypt(nonce, aad, sizeof(aad), plain.data(), plain.size(), tag + crypto::Key::kTagSize, tag);
+        crypto::SecureZero(plain.data(), plain.size());
+        if (ok) e.secrets = std::move(sealed);
+        return ok;
+    }
+
+    bool OpenSecrets(const crypto::Session& session, const EntryRef& e, Secrets& out) {
+        const size_t overhead = crypto::Key::kNonceSize + crypto::Key::kTagSize;
+        if (e.secrets.size < overhead) return false;
+        unsigned char aad[8];
+        SecretAad(e.id, aad);
+        const unsigned char* nonce = e.secrets.data;
+        const unsigned char* tag = nonce + crypto::Key::kNonceSize;
+        std::vector<unsigned char> plain(e.secrets.size - overhead);
+        if (!session.RecordKey().Decrypt(nonce, aad, sizeof(aad), tag + crypto::Key::kTagSize, plain.size(), plain.data(), tag)) {
+            return false;
+        }
+        if (!plain.empty() && plain[0] == kSecretsFormat) {
+            codec::Reader r(plain.data() + 1, plain.size() - 1);
+            codec::Bytes password;
+            codec::Bytes notes;
+            uint64_t changed = 0;
+            bool ok = r.Blob(password) && r.Blob(notes) && (r.Remaining() == 0 || r.U64(changed));
+            if (ok) {
+                out.changed = changed;
+                codec::DecodeUtf8(password, out.password);
+                codec::DecodeUtf8(notes, out.notes);
+            }
+            crypto::SecureZero(plain.data(), plain.size());
+            return ok;
+        }
+        // Escaped text written before the binary codec.
+        std::wstring text = FromUtf8(plain);
+        crypto::SecureZero(plain.data(), plain.size());
+        size_t tab = text.find(L'\t');
+        out.password = Unescape(text.substr(0, tab));
+        out.notes = tab == std::wstring::npos ? L"" : Unescape(text.substr(tab + 1));
+        ZeroText(text);
+        return true;
+    }
+
+    std::wstring JournalPath() {
+        std::wstring path = VaultPath();
+        return path.substr(0, path.size() - 4) + L".journal";
+    }
+
+    Store::~Store() {
+        Flush();
+    }
+
+    void Store::Flush() {
+        if (compactor_.joinable()) compactor_.join();
+    }
+
+    void Store::ClearPending() {
+        for (auto& r : pending_) crypto::SecureZero(r.data(), r.size());
+        pending_.clear();
+    }
+
+    bool Store::Open(crypto::Session& session, const std::wstring& password, Vault& out) {
+        Flush();
+        MappedFile blob;
+        if (!blob.Open(VaultPath())) return false;
         std::vector<unsigned char> plaintext;
-        if (!crypto::Decrypt(password, blob, plaintext)) return false;
-        out = Deserialize(plaintext);
+        if (!session.Open(password, blob.Data(), blob.Size(), plaintext)) return false;
+        Vault v;
+        bool migrated = false;
+        bool parsed = Deserialize(session, plaintext, v, migrated);
+        crypto::SecureZero(plaintext.data(), plaintext.size());
+        if (!parsed) {
+            session.Close();
+            return false;
+        }
+
+        unsigned char tag[crypto::Key::kTagSize];
+        if (!crypto::BlobTag(blob.Data(), blob.Size(), tag)) {
+            session.Close();
+            return false;
+        }
+        const uint64_t checkpointSize = blob.Size();
+        blob.Close();
+        std::vector<unsigned char> header = JournalHeader(tag);
+
+        // A crash mid-compaction can leave the new checkpoint in place with
+        // its journal still under the staging name.
+        MappedFile journal;
+        const std::wstring next = JournalPath() + L".next";
+        bool have = journal.Open(JournalPath()) && JournalMatches(journal, header);
+        if (!have) {
+            journal.Close();
+            MappedFile staged;
+            if (staged.Open(next) && JournalMatches(staged, header)) {
+                staged.Close();
+                have = Replace(next, JournalPath()) && journal.Open(JournalPath());
+            }
+        }
+
+        uint64_t seq = 0;
+        size_t off = kJournalHeaderLen;
+        if (have) {
+            const crypto::Key& key = JournalKey(session, header);
+            Replay replay(session, v);
+            std::vector<unsigned char> record;
+            unsigned char aad[kJournalHeaderLen + 8];
+            while (off + 4 <= journal.Size()) {
+                ULONG len = GetU32(journal.Data() + off);
+                if (len < kRecordOverhead || off + 4 + len > journal.Size()) break;
+                const unsigned char* nonce = journal.Data() + off + 4;
+                const unsigned char* rtag = nonce + crypto::Key::kNonceSize;
+                record.resize(len - kRecordOverhead);
+                RecordAad(header, seq + 1, aad);
+                if (!key.Decrypt(nonce, aad, sizeof(aad),
+                    rtag + crypto::Key::kTagSize, record.size(), record.data(), rtag)) {
+                    break;
+                }
+                replay.Apply(record);
+                crypto::SecureZero(record.data(), record.size());
+                off += 4 + len;
+                ++seq;
+            }
+            replay.Finish();
+            migrated = migrated || replay.migrated || GetU32(header.data() + 4) != kJournalVersion;
+            journal.Close();
+        } else if (!WriteDurable(JournalPath(), header)) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            ClearPending();
+            compacting_ = false;
+            header_ = header;
+            seq_ = seq;
+            journalSize_ = off;
+            checkpointSize_ = checkpointSize;
+        }
+
+        // The upgraded key is adopted only once a checkpoint under it is on
+        // disk; until then the old one stays in use and the next unlock
+        // tries again.
+        bool rewritten = true;
+        if (session.NeedsUpgrade()) {
+            crypto::Session upgraded;
+            if (session.Rekey(password, upgraded) && Compact(upgraded, v)) {
+                session.Swap(upgraded);
+                migrated = false;
+            } else {
+                rewritten = false;
+            }
+        }
+        if (migrated && !Compact(session, v)) rewritten = false;
+        rewriteFailed_ = !rewritten;
+        out = std::move(v);
         return true;
     }
 
-    bool Save(const std::wstring& password, const Vault& in) {
-        std::vector<unsigned char> plaintext = Serialize(in);
-        crypto::Blob blob;
-        if (!crypto::Encrypt(password, plaintext, blob)) return false;
-        return WriteFile(VaultPath(), blob.data);
+    bool Store::Create(const crypto::Session& session, const Vault& in) {
+        return Compact(session, in);
+    }
+
+    bool Store::Compact(const crypto::Session& session, const Vault& in) {
+        Flush();
+        unsigned char tag[crypto::Key::kTagSize];
+        uint64_t size = 0;
+        if (!WriteCheckpoint(session, in, VaultPath() + L".tmp", checkpoint_, tag, size)) return false;
+        std::lock_guard<std::mutex> guard(lock_);
+        ClearPending();
+        return Commit(session, tag, size);
+    }
+
+    // Called with lock_ held and the new checkpoint staged as vault.dat.tmp.
+    // The new journal (records that arrived during compaction, resealed
+    // against the new checkpoint) is made durable before the checkpoint is
+    // swapped in, so a crash at any point leaves a consistent pair on disk.
+    bool Store::Commit(const crypto::Session& session, const unsigned char* tag, uint64_t checkpointSize) {
+        std::vector<unsigned char> header = JournalHeader(tag);
+        std::vector<unsigned char> journal = header;
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            if (!SealRecord(session, header, i + 1, pending_[i], journal)) return false;
+        }
+        const std::wstring next = JournalPath() + L".next";
+        if (!WriteDurable(next, journal)) return false;
+        if (!Replace(VaultPath() + L".tmp", VaultPath())) {
+            DeleteFileW(next.c_str());
+            return false;
+        }
+        if (!Replace(next, JournalPath())) {
+            if (!WriteDurable(JournalPath(), journal)) {
+                // The old journal no longer matches the checkpoint; Open
+                // recovers from the staged one, and Apply refuses until a
+                // full checkpoint succeeds.
+                header_.clear();
+                return false;
+            }
+            DeleteFileW(next.c_str());
+        }
+        header_ = header;
+        seq_ = pending_.size();
+        journalSize_ = journal.size();
+        checkpointSize_ = checkpointSize;
+        ++checkpoints_;
+        ClearPending();
+        return true;
+    }
+
+    uint64_t Store::Checkpoints() {
+        std::lock_guard<std::mutex> guard(lock_);
+        return checkpoints_;
+    }
+
+    bool Store::Put(const crypto::Session& session, const Vault& current, const Entry& e) {
+        std::vector<Change> batch(1);
+        batch[0].id = e.id;
+        batch[0].entry = e;
+        return Apply(session, current, batch);
+    }
+
+    bool Store::Remove(const crypto::Session& session, const Vault& current, uint64_t id) {
+        std::vector<Change> batch(1);
+        batch[0].id = id;
+        batch[0].remove = true;
+        return Apply(session, current, batch);
+    }
+
+    // Seals the whole batch onto the journal with a single write and flush.
+    // current must already contain the changes; it is snapshotted when the
+    // journal crosses the compaction threshold.
+    bool Store::Apply(const crypto::Session& session, const Vault& current, const std::vector<Change>& batch) {
+        std::unique_lock<std::mutex> guard(lock_);
+        if (header_.empty()) return false;
+        frame_.clear();
+        std::vector<std::vector<unsigned char>> resealed;
+        uint64_t seq = seq_;
+        bool ok = true;
+        for (size_t i = 0; ok && i < batch.size(); ++i) {
+            record_.clear();
+            codec::Writer w(record_);
+            if (batch[i].remove) {
+                w.U8(kOpRemove);
+                w.U64(batch[i].id);
+            } else {
+                w.U8(kOpPut);
+                codec::WriteEntry(w, batch[i].entry);
+            }
+            ok = SealRecord(session, header_, ++seq, record_, frame_);
+            if (ok && compacting_) resealed.push_back(record_);
+            crypto::SecureZero(record_.data(), record_.size());
+        }
+        ok = ok && WriteAt(JournalPath(), journalSize_, frame_);
+        if (!ok) {
+            for (auto& r : resealed) crypto::SecureZero(r.data(), r.size());
+            return false;
+        }
+        seq_ = seq;
+        journalSize_ += frame_.size();
+        for (auto& r : resealed) pending_.push_back(std::move(r));
+        if (compacting_ || journalSize_ <= std::max(kMinCompactBytes, checkpointSize_ / 2)) return true;
+        compacting_ = true;
+        guard.unlock();
+        StartCompaction(session, current);
+        return true;
+    }
+
+    // The compactor works from its own copy of the session, so a Swap or
+    // Close of the caller's session cannot change the key, parameters or
+    // wrapped records key under it.
+    void Store::StartCompaction(const crypto::Session& session, const Vault& current) {
+        Flush();
+        std::unique_ptr<crypto::Session> s(new crypto::Session);
+        if (!session.Copy(*s)) {
+            std::lock_guard<std::mutex> guard(lock_);
+            compacting_ = false;
+            return;
+        }
+        compactor_ = std::thread([this, s = std::move(s), snapshot = current]() {
+            unsigned char tag[crypto::Key::kTagSize];
+            uint64_t size = 0;
+            const std::wstring tmp = VaultPath() + L".tmp";
+            bool ok = WriteCheckpoint(*s, snapshot, tmp, checkpoint_, tag, size);
+            std::lock_guard<std::mutex> guard(lock_);
+            if (ok) ok = Commit(*s, tag, size);
+            if (!ok) {
+                DeleteFileW(tmp.c_str());
+                ClearPending();
+            }
+            compacting_ = false;
+        });
     }
 }
@@ -1,23 +1,88 @@
 #pragma once
 
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
-struct Entry {
-    std::wstring title;
-    std::wstring category;
-    std::wstring username;
+#include "crypto.h"
+#include "entries.h"
+
+struct Secrets {
     std::wstring password;
-    std::wstring url;
     std::wstring notes;
+    // When the password was last set, in seconds since 1970; 0 if unknown,
+    // as for entries imported or saved before this was recorded.
+    uint64_t changed = 0;
+
+    Secrets() = default;
+    Secrets(const Secrets&) = delete;
+    Secrets& operator=(const Secrets&) = delete;
+    ~Secrets();
 };
 
 struct Vault {
-    std::vector<Entry> entries;
+    EntryTable entries;
+    uint64_t nextId = 1;
 };
 
 namespace vault {
     std::wstring VaultPath();
-    bool Load(const std::wstring& password, Vault& out);
-    bool Save(const std::wstring& password, const Vault& in);
+    std::wstring JournalPath();
+
+    // One journaled change: entry replaces the entry with the same id, or
+    // remove deletes it.
+    struct Change {
+        uint64_t id = 0;
+        bool remove = false;
+        Entry entry;
+    };
+
+    bool SealSecrets(const crypto::Session& session, Entry& e, const Secrets& in);
+    bool OpenSecrets(const crypto::Session& session, const EntryRef& e, Secrets& out);
+
+    // vault.dat holds the last checkpoint; vault.journal holds one sealed
+    // record per change made since then, bound to that checkpoint. Once the
+    // journal outgrows its threshold a background compactor folds it into a
+    // new checkpoint.
+    class Store {
+    public:
+        Store() = default;
+        ~Store();
+        Store(const Store&) = delete;
+        Store& operator=(const Store&) = delete;
+
+        bool Open(crypto::Session& session, const std::wstring& password, Vault& out);
+        bool Create(const crypto::Session& session, const Vault& in);
+        bool Put(const crypto::Session& session, const Vault& current, const Entry& e);
+        bool Remove(const crypto::Session& session, const Vault& current, uint64_t id);
+        bool Apply(const crypto::Session& session, const Vault& current, const std::vector<Change>& batch);
+        bool Compact(const crypto::Session& session, const Vault& in);
+        void Flush();
+        // Set by Open when the vault needed rewriting (a KDF upgrade or an
+        // older format) and the new checkpoint could not be written.
+        bool RewriteFailed() const { return rewriteFailed_; }
+        // Checkpoints committed so far, background compactions included.
+        uint64_t Checkpoints();
+
+    private:
+        bool Commit(const crypto::Session& session, const unsigned char* tag, uint64_t checkpointSize);
+        void StartCompaction(const crypto::Session& session, const Vault& current);
+        void ClearPending();
+
+        std::mutex lock_;
+        std::thread compactor_;
+        bool compacting_ = false;
+        std::vector<std::vector<unsigned char>> pending_;
+        std::vector<unsigned char> record_;
+        std::vector<unsigned char> frame_;
+        std::vector<unsigned char> checkpoint_;
+        std::vector<unsigned char> header_;
+        uint64_t seq_ = 0;
+        uint64_t journalSize_ = 0;
+        uint64_t checkpointSize_ = 0;
+        uint64_t checkpoints_ = 0;
+        bool rewriteFailed_ = false;
+    };
 }
@@ -0,0 +1,35 @@
+#include "vault_view.h"
+
+namespace view {
+    void VaultView::Refresh(const Vault& v, const search::Index& index, const categories::Dictionary& cats,
+        const std::wstring& text, uint32_t category, size_t limit) {
+        const bool any = category == categories::Dictionary::kAny;
+        auto accept = [&](size_t i) { return any || cats.Id(i) == category; };
+        if (category != category_) {
+            query_.Reset();
+            category_ = category;
+        }
+        rows_.clear();
+        if (!text.empty()) {
+            query_.Rank(index, text, accept, limit, rows_);
+            return;
+        }
+        rows_.reserve(v.entries.Size());
+        for (size_t i = 0; i < v.entries.Size(); ++i) {
+            if (accept(i)) rows_.push_back(i);
+        }
+    }
+
+    std::wstring_view VaultView::Cell(const Vault& v, size_t row, int column) const {
+        const size_t pos = Position(row);
+        if (pos >= v.entries.Size()) return L"";
+        const EntryRef e = v.entries[pos];
+        switch (column) {
+        case 0: return e.title;
+        case 1: return e.category;
+        case 2: return e.username;
+        case 3: return e.url;
+        }
+        return L"";
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "categories.h"
+#include "search.h"
+#include "vault.h"
+
+namespace view {
+    // The rows of the vault list as positions into Vault::entries, filtered
+    // and ordered once per refresh. The list control asks for cells by row,
+    // so nothing is copied into it up front.
+    class VaultView {
+    public:
+        static const size_t kNoRow = (size_t)-1;
+
+        // category is an id from cats, or Dictionary::kAny. A non-empty text
+        // ranks the best limit matches instead of listing in vault order.
+        // Typing narrows from the previous refresh while the index and the
+        // category stay the same.
+        void Refresh(const Vault& v, const search::Index& index, const categories::Dictionary& cats,
+            const std::wstring& text, uint32_t category, size_t limit);
+
+        size_t Count() const { return rows_.size(); }
+        // Vault position shown in row, or kNoRow.
+        size_t Position(size_t row) const { return row < rows_.size() ? rows_[row] : kNoRow; }
+        // Title, category, username and url for columns 0-3; empty for an
+        // unknown row or column. Null-terminated, like every EntryRef field.
+        std::wstring_view Cell(const Vault& v, size_t row, int column) const;
+
+    private:
+        std::vector<size_t> rows_;
+        search::QuerySession query_;
+        uint32_t category_ = categories::Dictionary::kAny;
+    };
+}
@@ -0,0 +1,262 @@
+#include "wordlist.h"
+
+namespace passgen {
+    const wchar_t* const kWords[kWordCount] = {
+        L"abandon", L"ability", L"able", L"about", L"above", L"absent", L"absorb", L"abstract",
+        L"absurd", L"abuse", L"access", L"accident", L"account", L"accuse", L"achieve", L"acid",
+        L"acoustic", L"acquire", L"across", L"act", L"action", L"actor", L"actress", L"actual",
+        L"adapt", L"add", L"addict", L"address", L"adjust", L"admit", L"adult", L"advance",
+        L"advice", L"aerobic", L"affair", L"afford", L"afraid", L"again", L"age", L"agent",
+        L"agree", L"ahead", L"aim", L"air", L"airport", L"aisle", L"alarm", L"album",
+        L"alcohol", L"alert", L"alien", L"all", L"alley", L"allow", L"almost", L"alone",
+        L"alpha", L"already", L"also", L"alter", L"always", L"amateur", L"amazing", L"among",
+        L"amount", L"amused", L"analyst", L"anchor", L"ancient", L"anger", L"angle", L"angry",
+        L"animal", L"ankle", L"announce", L"annual", L"another", L"answer", L"antenna", L"antique",
+        L"anxiety", L"any", L"apart", L"apology", L"appear", L"apple", L"approve", L"april",
+        L"arch", L"arctic", L"area", L"arena", L"argue", L"arm", L"armed", L"armor",
+        L"army", L"around", L"arrange", L"arrest", L"arrive", L"arrow", L"art", L"artefact",
+        L"artist", L"artwork", L"ask", L"aspect", L"assault", L"asset", L"assist", L"assume",
+        L"asthma", L"athlete", L"atom", L"attack", L"attend", L"attitude", L"attract", L"auction",
+        L"audit", L"august", L"aunt", L"author", L"auto", L"autumn", L"average", L"avocado",
+        L"avoid", L"awake", L"aware", L"away", L"awesome", L"awful", L"awkward", L"axis",
+        L"baby", L"bachelor", L"bacon", L"badge", L"bag", L"balance", L"balcony", L"ball",
+        L"bamboo", L"banana", L"banner", L"bar", L"barely", L"bargain", L"barrel", L"base",
+        L"basic", L"basket", L"battle", L"beach", L"bean", L"beauty", L"because", L"become",
+        L"beef", L"before", L"begin", L"behave", L"behind", L"believe", L"below", L"belt",
+        L"bench", L"benefit", L"best", L"betray", L"better", L"between", L"beyond", L"bicycle",
+        L"bid", L"bike", L"bind", L"biology", L"bird", L"birth", L"bitter", L"black",
+        L"blade", L"blame", L"blanket", L"blast", L"bleak", L"bless", L"blind", L"blood",
+        L"blossom", L"blouse", L"blue", L"blur", L"blush", L"board", L"boat", L"body",
+        L"boil", L"bomb", L"bone", L"bonus", L"book", L"boost", L"border", L"boring",
+        L"borrow", L"boss", L"bottom", L"bounce", L"box", L"boy", L"bracket", L"brain",
+        L"brand", L"brass", L"brave", L"bread", L"breeze", L"brick", L"bridge", L"brief",
+        L"bright", L"bring", L"brisk", L"broccoli", L"broken", L"bronze", L"broom", L"brother",
+        L"brown", L"brush", L"bubble", L"buddy", L"budget", L"buffalo", L"build", L"bulb",
+        L"bulk", L"bullet", L"bundle", L"bunker", L"burden", L"burger", L"burst", L"bus",
+        L"business", L"busy", L"butter", L"buyer", L"buzz", L"cabbage", L"cabin", L"cable",
+        L"cactus", L"cage", L"cake", L"call", L"calm", L"camera", L"camp", L"can",
+        L"canal", L"cancel", L"candy", L"cannon", L"canoe", L"canvas", L"canyon", L"capable",
+        L"capital", L"captain", L"car", L"carbon", L"card", L"cargo", L"carpet", L"carry",
+        L"cart", L"case", L"cash", L"casino", L"castle", L"casual", L"cat", L"catalog",
+        L"catch", L"category", L"cattle", L"caught", L"cause", L"caution", L"cave", L"ceiling",
+        L"celery", L"cement", L"census", L"century", L"cereal", L"certain", L"chair", L"chalk",
+        L"champion", L"change", L"chaos", L"chapter", L"charge", L"chase", L"chat", L"cheap",
+        L"check", L"cheese", L"chef", L"cherry", L"chest", L"chicken", L"chief", L"child",
+        L"chimney", L"choice", L"choose", L"chronic", L"chuckle", L"chunk", L"churn", L"cigar",
+        L"cinnamon", L"circle", L"citizen", L"city", L"civil", L"claim", L"clap", L"clarify",
+        L"claw", L"clay", L"clean", L"clerk", L"clever", L"click", L"client", L"cliff",
+        L"climb", L"clinic", L"clip", L"clock", L"clog", L"close", L"cloth", L"cloud",
+        L"clown", L"club", L"clump", L"cluster", L"clutch", L"coach", L"coast", L"coconut",
+        L"code", L"coffee", L"coil", L"coin", L"collect", L"color", L"column", L"combine",
+        L"come", L"comfort", L"comic", L"common", L"company", L"concert", L"conduct", L"confirm",
+        L"congress", L"connect", L"consider", L"control", L"convince", L"cook", L"cool", L"copper",
+        L"copy", L"coral", L"core", L"corn", L"correct", L"cost", L"cotton", L"couch",
+        L"country", L"couple", L"course", L"cousin", L"cover", L"coyote", L"crack", L"cradle",
+        L"craft", L"cram", L"crane", L"crash", L"crater", L"crawl", L"crazy", L"cream",
+        L"credit", L"creek", L"crew", L"cricket", L"crime", L"crisp", L"critic", L"crop",
+        L"cross", L"crouch", L"crowd", L"crucial", L"cruel", L"cruise", L"crumble", L"crunch",
+        L"crush", L"cry", L"crystal", L"cube", L"culture", L"cup", L"cupboard", L"curious",
+        L"current", L"curtain", L"curve", L"cushion", L"custom", L"cute", L"cycle", L"dad",
+        L"damage", L"damp", L"dance", L"danger", L"daring", L"dash", L"daughter", L"dawn",
+        L"day", L"deal", L"debate", L"debris", L"decade", L"december", L"decide", L"decline",
+        L"decorate", L"decrease", L"deer", L"defense", L"define", L"defy", L"degree", L"delay",
+        L"deliver", L"demand", L"demise", L"denial", L"dentist", L"deny", L"depart", L"depend",
+        L"deposit", L"depth", L"deputy", L"derive", L"describe", L"desert", L"design", L"desk",
+        L"despair", L"destroy", L"detail", L"detect", L"develop", L"device", L"devote", L"diagram",
+        L"dial", L"diamond", L"diary", L"dice", L"diesel", L"diet", L"differ", L"digital",
+        L"dignity", L"dilemma", L"dinner", L"dinosaur", L"direct", L"dirt", L"disagree", L"discover",
+        L"disease", L"dish", L"dismiss", L"disorder", L"display", L"distance", L"divert", L"divide",
+        L"divorce", L"dizzy", L"doctor", L"document", L"dog", L"doll", L"dolphin", L"domain",
+        L"donate", L"donkey", L"donor", L"door", L"dose", L"double", L"dove", L"draft",
+        L"dragon", L"drama", L"drastic", L"draw", L"dream", L"dress", L"drift", L"drill",
+        L"drink", L"drip", L"drive", L"drop", L"drum", L"dry", L"duck", L"dumb",
+        L"dune", L"during", L"dust", L"dutch", L"duty", L"dwarf", L"dynamic", L"eager",
+        L"eagle", L"early", L"earn", L"earth", L"easily", L"east", L"easy", L"echo",
+        L"ecology", L"economy", L"edge", L"edit", L"educate", L"effort", L"egg", L"eight",
+        L"either", L"elbow", L"elder", L"electric", L"elegant", L"element", L"elephant", L"elevator",
+        L"elite", L"else", L"embark", L"embody", L"embrace", L"emerge", L"emotion", L"employ",
+        L"empower", L"empty", L"enable", L"enact", L"end", L"endless", L"endorse", L"enemy",
+        L"energy", L"enforce", L"engage", L"engine", L"enhance", L"enjoy", L"enlist", L"enough",
+        L"enrich", L"enroll", L"ensure", L"enter", L"entire", L"entry", L"envelope", L"episode",
+        L"equal", L"equip", L"era", L"erase", L"erode", L"erosion", L"error", L"erupt",
+        L"escape", L"essay", L"essence", L"estate", L"eternal", L"ethics", L"evidence", L"evil",
+        L"evoke", L"evolve", L"exact", L"example", L"excess", L"exchange", L"excite", L"exclude",
+        L"excuse", L"execute", L"exercise", L"exhaust", L"exhibit", L"exile", L"exist", L"exit",
+        L"exotic", L"expand", L"expect", L"expire", L"explain", L"expose", L"express", L"extend",
+        L"extra", L"eye", L"eyebrow", L"fabric", L"face", L"faculty", L"fade", L"faint",
+        L"faith", L"fall", L"false", L"fame", L"family", L"famous", L"fan", L"fancy",
+        L"fantasy", L"farm", L"fashion", L"fat", L"fatal", L"father", L"fatigue", L"fault",
+        L"favorite", L"feature", L"february", L"federal", L"fee", L"feed", L"feel", L"female",
+        L"fence", L"festival", L"fetch", L"fever", L"few", L"fiber", L"fiction", L"field",
+        L"figure", L"file", L"film", L"filter", L"final", L"find", L"fine", L"finger",
+        L"finish", L"fire", L"firm", L"first", L"fiscal", L"fish", L"fit", L"fitness",
+        L"fix", L"flag", L"flame", L"flash", L"flat", L"flavor", L"flee", L"flight",
+        L"flip", L"float", L"flock", L"floor", L"flower", L"fluid", L"flush", L"fly",
+        L"foam", L"focus", L"fog", L"foil", L"fold", L"follow", L"food", L"foot",
+        L"force", L"forest", L"forget", L"fork", L"fortune", L"forum", L"forward", L"fossil",
+        L"foster", L"found", L"fox", L"fragile", L"frame", L"frequent", L"fresh", L"friend",
+        L"fringe", L"frog", L"front", L"frost", L"frown", L"frozen", L"fruit", L"fuel",
+        L"fun", L"funny", L"furnace", L"fury", L"future", L"gadget", L"gain", L"galaxy",
+        L"gallery", L"game", L"gap", L"garage", L"garbage", L"garden", L"garlic", L"garment",
+        L"gas", L"gasp", L"gate", L"gather", L"gauge", L"gaze", L"general", L"genius",
+        L"genre", L"gentle", L"genuine", L"gesture", L"ghost", L"giant", L"gift", L"giggle",
+        L"ginger", L"giraffe", L"girl", L"give", L"glad", L"glance", L"glare", L"glass",
+        L"glide", L"glimpse", L"globe", L"gloom", L"glory", L"glove", L"glow", L"glue",
+        L"goat", L"goddess", L"gold", L"good", L"goose", L"gorilla", L"gospel", L"gossip",
+        L"govern", L"gown", L"grab", L"grace", L"grain", L"grant", L"grape", L"grass",
+        L"gravity", L"great", L"green", L"grid", L"grief", L"grit", L"grocery", L"group",
+        L"grow", L"grunt", L"guard", L"guess", L"guide", L"guilt", L"guitar", L"gun",
+        L"gym", L"habit", L"hair", L"half", L"hammer", L"hamster", L"hand", L"happy",
+        L"harbor", L"hard", L"harsh", L"harvest", L"hat", L"have", L"hawk", L"hazard",
+        L"head", L"health", L"heart", L"heavy", L"hedgehog", L"height", L"hello", L"helmet",
+        L"help", L"hen", L"hero", L"hidden", L"high", L"hill", L"hint", L"hip",
+        L"hire", L"history", L"hobby", L"hockey", L"hold", L"hole", L"holiday", L"hollow",
+        L"home", L"honey", L"hood", L"hope", L"horn", L"horror", L"horse", L"hospital",
+        L"host", L"hotel", L"hour", L"hover", L"hub", L"huge", L"human", L"humble",
+        L"humor", L"hundred", L"hungry", L"hunt", L"hurdle", L"hurry", L"hurt", L"husband",
+        L"hybrid", L"ice", L"icon", L"idea", L"identify", L"idle", L"ignore", L"ill",
+        L"illegal", L"illness", L"image", L"imitate", L"immense", L"immune", L"impact", L"impose",
+        L"improve", L"impulse", L"inch", L"include", L"income", L"increase", L"index", L"indicate",
+        L"indoor", L"industry", L"infant", L"inflict", L"inform", L"inhale", L"inherit", L"initial",
+        L"inject", L"injury", L"inmate", L"inner", L"innocent", L"input", L"inquiry", L"insane",
+        L"insect", L"inside", L"inspire", L"install", L"intact", L"interest", L"into", L"invest",
+        L"invite", L"involve", L"iron", L"island", L"isolate", L"issue", L"item", L"ivory",
+        L"jacket", L"jaguar", L"jar", L"jazz", L"jealous", L"jeans", L"jelly", L"jewel",
+        L"job", L"join", L"joke", L"journey", L"joy", L"judge", L"juice", L"jump",
+        L"jungle", L"junior", L"junk", L"just", L"kangaroo", L"keen", L"keep", L"ketchup",
+        L"key", L"kick", L"kid", L"kidney", L"kind", L"kingdom", L"kiss", L"kit",
+        L"kitchen", L"kite", L"kitten", L"kiwi", L"knee", L"knife", L"knock", L"know",
+        L"lab", L"label", L"labor", L"ladder", L"lady", L"lake", L"lamp", L"language",
+        L"laptop", L"large", L"later", L"latin", L"laugh", L"laundry", L"lava", L"law",
+        L"lawn", L"lawsuit", L"layer", L"lazy", L"leader", L"leaf", L"learn", L"leave",
+        L"lecture", L"left", L"leg", L"legal", L"legend", L"leisure", L"lemon", L"lend",
+        L"length", L"lens", L"leopard", L"lesson", L"letter", L"level", L"liar", L"liberty",
+        L"library", L"license", L"life", L"lift", L"light", L"like", L"limb", L"limit",
+        L"link", L"lion", L"liquid", L"list", L"little", L"live", L"lizard", L"load",
+        L"loan", L"lobster", L"local", L"lock", L"logic", L"lonely", L"long", L"loop",
+        L"lottery", L"loud", L"lounge", L"love", L"loyal", L"lucky", L"luggage", L"lumber",
+        L"lunar", L"lunch", L"luxury", L"lyrics", L"machine", L"mad", L"magic", L"magnet",
+        L"maid", L"mail", L"main", L"major", L"make", L"mammal", L"man", L"manage",
+        L"mandate", L"mango", L"mansion", L"manual", L"maple", L"marble", L"march", L"margin",
+        L"marine", L"market", L"marriage", L"mask", L"mass", L"master", L"match", L"material",
+        L"math", L"matrix", L"matter", L"maximum", L"maze", L"meadow", L"mean", L"measure",
+        L"meat", L"mechanic", L"medal", L"media", L"melody", L"melt", L"member", L"memory",
+        L"mention", L"menu", L"mercy", L"merge", L"merit", L"merry", L"mesh", L"message",
+        L"metal", L"method", L"middle", L"midnight", L"milk", L"million", L"mimic", L"mind",
+        L"minimum", L"minor", L"minute", L"miracle", L"mirror", L"misery", L"miss", L"mistake",
+        L"mix", L"mixed", L"mixture", L"mobile", L"model", L"modify", L"mom", L"moment",
+        L"monitor", L"monkey", L"monster", L"month", L"moon", L"moral", L"more", L"morning",
+        L"mosquito", L"mother", L"motion", L"motor", L"mountain", L"mouse", L"move", L"movie",
+        L"much", L"muffin", L"mule", L"multiply", L"muscle", L"museum", L"mushroom", L"music",
+        L"must", L"mutual", L"myself", L"mystery", L"myth", L"naive", L"name", L"napkin",
+        L"narrow", L"nasty", L"nation", L"nature", L"near", L"neck", L"need", L"negative",
+        L"neglect", L"neither", L"nephew", L"nerve", L"nest", L"net", L"network", L"neutral",
+        L"never", L"news", L"next", L"nice", L"night", L"noble", L"noise", L"nominee",
+        L"noodle", L"normal", L"north", L"nose", L"notable", L"note", L"nothing", L"notice",
+        L"novel", L"now", L"nuclear", L"number", L"nurse", L"nut", L"oak", L"obey",
+        L"object", L"oblige", L"obscure", L"observe", L"obtain", L"obvious", L"occur", L"ocean",
+        L"october", L"odor", L"off", L"offer", L"office", L"often", L"oil", L"okay",
+        L"old", L"olive", L"olympic", L"omit", L"once", L"one", L"onion", L"online",
+        L"only", L"open", L"opera", L"opinion", L"oppose", L"option", L"orange", L"orbit",
+        L"orchard", L"order", L"ordinary", L"organ", L"orient", L"original", L"orphan", L"ostrich",
+        L"other", L"outdoor", L"outer", L"output", L"outside", L"oval", L"oven", L"over",
+        L"own", L"owner", L"oxygen", L"oyster", L"ozone", L"pact", L"paddle", L"page",
+        L"pair", L"palace", L"palm", L"panda", L"panel", L"panic", L"panther", L"paper",
+        L"parade", L"parent", L"park", L"parrot", L"party", L"pass", L"patch", L"path",
+        L"patient", L"patrol", L"pattern", L"pause", L"pave", L"payment", L"peace", L"peanut",
+        L"pear", L"peasant", L"pelican", L"pen", L"penalty", L"pencil", L"people", L"pepper",
+        L"perfect", L"permit", L"person", L"pet", L"phone", L"photo", L"phrase", L"physical",
+        L"piano", L"picnic", L"picture", L"piece", L"pig", L"pigeon", L"pill", L"pilot",
+        L"pink", L"pioneer", L"pipe", L"pistol", L"pitch", L"pizza", L"place", L"planet",
+        L"plastic", L"plate", L"play", L"please", L"pledge", L"pluck", L"plug", L"plunge",
+        L"poem", L"poet", L"point", L"polar", L"pole", L"police", L"pond", L"pony",
+        L"pool", L"popular", L"portion", L"position", L"possible", L"post", L"potato", L"pottery",
+        L"poverty", L"powder", L"power", L"practice", L"praise", L"predict", L"prefer", L"prepare",
+        L"present", L"pretty", L"prevent", L"price", L"pride", L"primary", L"print", L"priority",
+        L"prison", L"private", L"prize", L"problem", L"process", L"produce", L"profit", L"program",
+        L"project", L"promote", L"proof", L"property", L"prosper", L"protect", L"proud", L"provide",
+        L"public", L"pudding", L"pull", L"pulp", L"pulse", L"pumpkin", L"punch", L"pupil",
+        L"puppy", L"purchase", L"purity", L"purpose", L"purse", L"push", L"put", L"puzzle",
+        L"pyramid", L"quality", L"quantum", L"quarter", L"question", L"quick", L"quit", L"quiz",
+        L"quote", L"rabbit", L"raccoon", L"race", L"rack", L"radar", L"radio", L"rail",
+        L"rain", L"raise", L"rally", L"ramp", L"ranch", L"random", L"range", L"rapid",
+        L"rare", L"rate", L"rather", L"raven", L"raw", L"razor", L"ready", L"real",
+        L"reason", L"rebel", L"rebuild", L"recall", L"receive", L"recipe", L"record", L"recycle",
+        L"reduce", L"reflect", L"reform", L"refuse", L"region", L"regret", L"regular", L"reject",
+        L"relax", L"release", L"relief", L"rely", L"remain", L"remember", L"remind", L"remove",
+        L"render", L"renew", L"rent", L"reopen", L"repair", L"repeat", L"replace", L"report",
+        L"require", L"rescue", L"resemble", L"resist", L"resource", L"response", L"result", L"retire",
+        L"retreat", L"return", L"reunion", L"reveal", L"review", L"reward", L"rhythm", L"rib",
+        L"ribbon", L"rice", L"rich", L"ride", L"ridge", L"rifle", L"right", L"rigid",
+        L"ring", L"riot", L"ripple", L"risk", L"ritual", L"rival", L"river", L"road",
+        L"roast", L"robot", L"robust", L"rocket", L"romance", L"roof", L"rookie", L"room",
+        L"rose", L"rotate", L"rough", L"round", L"route", L"royal", L"rubber", L"rude",
+        L"rug", L"rule", L"run", L"runway", L"rural", L"sad", L"saddle", L"sadness",
+        L"safe", L"sail", L"salad", L"salmon", L"salon", L"salt", L"salute", L"same",
+        L"sample", L"sand", L"satisfy", L"satoshi", L"sauce", L"sausage", L"save", L"say",
+        L"scale", L"scan", L"scare", L"scatter", L"scene", L"scheme", L"school", L"science",
+        L"scissors", L"scorpion", L"scout", L"scrap", L"screen", L"script", L"scrub", L"sea",
+        L"search", L"season", L"seat", L"second", L"secret", L"section", L"security", L"seed",
+        L"seek", L"segment", L"select", L"sell", L"seminar", L"senior", L"sense", L"sentence",
+        L"series", L"service", L"session", L"settle", L"setup", L"seven", L"shadow", L"shaft",
+        L"shallow", L"share", L"shed", L"shell", L"sheriff", L"shield", L"shift", L"shine",
+        L"ship", L"shiver", L"shock", L"shoe", L"shoot", L"shop", L"short", L"shoulder",
+        L"shove", L"shrimp", L"shrug", L"shuffle", L"shy", L"sibling", L"sick", L"side",
+        L"siege", L"sight", L"sign", L"silent", L"silk", L"silly", L"silver", L"similar",
+        L"simple", L"since", L"sing", L"siren", L"sister", L"situate", L"six", L"size",
+        L"skate", L"sketch", L"ski", L"skill", L"skin", L"skirt", L"skull", L"slab",
+        L"slam", L"sleep", L"slender", L"slice", L"slide", L"slight", L"slim", L"slogan",
+        L"slot", L"slow", L"slush", L"small", L"smart", L"smile", L"smoke", L"smooth",
+        L"snack", L"snake", L"snap", L"sniff", L"snow", L"soap", L"soccer", L"social",
+        L"sock", L"soda", L"soft", L"solar", L"soldier", L"solid", L"solution", L"solve",
+        L"someone", L"song", L"soon", L"sorry", L"sort", L"soul", L"sound", L"soup",
+        L"source", L"south", L"space", L"spare", L"spatial", L"spawn", L"speak", L"special",
+        L"speed", L"spell", L"spend", L"sphere", L"spice", L"spider", L"spike", L"spin",
+        L"spirit", L"split", L"spoil", L"sponsor", L"spoon", L"sport", L"spot", L"spray",
+        L"spread", L"spring", L"spy", L"square", L"squeeze", L"squirrel", L"stable", L"stadium",
+        L"staff", L"stage", L"stairs", L"stamp", L"stand", L"start", L"state", L"stay",
+        L"steak", L"steel", L"stem", L"step", L"stereo", L"stick", L"still", L"sting",
+        L"stock", L"stomach", L"stone", L"stool", L"story", L"stove", L"strategy", L"street",
+        L"strike", L"strong", L"struggle", L"student", L"stuff", L"stumble", L"style", L"subject",
+        L"submit", L"subway", L"success", L"such", L"sudden", L"suffer", L"sugar", L"suggest",
+        L"suit", L"summer", L"sun", L"sunny", L"sunset", L"super", L"supply", L"supreme",
+        L"sure", L"surface", L"surge", L"surprise", L"surround", L"survey", L"suspect", L"sustain",
+        L"swallow", L"swamp", L"swap", L"swarm", L"swear", L"sweet", L"swift", L"swim",
+        L"swing", L"switch", L"sword", L"symbol", L"symptom", L"syrup", L"system", L"table",
+        L"tackle", L"tag", L"tail", L"talent", L"talk", L"tank", L"tape", L"target",
+        L"task", L"taste", L"tattoo", L"taxi", L"teach", L"team", L"tell", L"ten",
+        L"tenant", L"tennis", L"tent", L"term", L"test", L"text", L"thank", L"that",
+        L"theme", L"then", L"theory", L"there", L"they", L"thing", L"this", L"thought",
+        L"three", L"thrive", L"throw", L"thumb", L"thunder", L"ticket", L"tide", L"tiger",
+        L"tilt", L"timber", L"time", L"tiny", L"tip", L"tired", L"tissue", L"title",
+        L"toast", L"tobacco", L"today", L"toddler", L"toe", L"together", L"toilet", L"token",
+        L"tomato", L"tomorrow", L"tone", L"tongue", L"tonight", L"tool", L"tooth", L"top",
+        L"topic", L"topple", L"torch", L"tornado", L"tortoise", L"toss", L"total", L"tourist",
+        L"toward", L"tower", L"town", L"toy", L"track", L"trade", L"traffic", L"tragic",
+        L"train", L"transfer", L"trap", L"trash", L"travel", L"tray", L"treat", L"tree",
+        L"trend", L"trial", L"tribe", L"trick", L"trigger", L"trim", L"trip", L"trophy",
+        L"trouble", L"truck", L"true", L"truly", L"trumpet", L"trust", L"truth", L"try",
+        L"tube", L"tuition", L"tumble", L"tuna", L"tunnel", L"turkey", L"turn", L"turtle",
+        L"twelve", L"twenty", L"twice", L"twin", L"twist", L"two", L"type", L"typical",
+        L"ugly", L"umbrella", L"unable", L"unaware", L"uncle", L"uncover", L"under", L"undo",
+        L"unfair", L"unfold", L"unhappy", L"uniform", L"unique", L"unit", L"universe", L"unknown",
+        L"unlock", L"until", L"unusual", L"unveil", L"update", L"upgrade", L"uphold", L"upon",
+        L"upper", L"upset", L"urban", L"urge", L"usage", L"use", L"used", L"useful",
+        L"useless", L"usual", L"utility", L"vacant", L"vacuum", L"vague", L"valid", L"valley",
+        L"valve", L"van", L"vanish", L"vapor", L"various", L"vast", L"vault", L"vehicle",
+        L"velvet", L"vendor", L"venture", L"venue", L"verb", L"verify", L"version", L"very",
+        L"vessel", L"veteran", L"viable", L"vibrant", L"vicious", L"victory", L"video", L"view",
+        L"village", L"vintage", L"violin", L"virtual", L"virus", L"visa", L"visit", L"visual",
+        L"vital", L"vivid", L"vocal", L"voice", L"void", L"volcano", L"volume", L"vote",
+        L"voyage", L"wage", L"wagon", L"wait", L"walk", L"wall", L"walnut", L"want",
+        L"warfare", L"warm", L"warrior", L"wash", L"wasp", L"waste", L"water", L"wave",
+        L"way", L"wealth", L"weapon", L"wear", L"weasel", L"weather", L"web", L"wedding",
+        L"weekend", L"weird", L"welcome", L"west", L"wet", L"whale", L"what", L"wheat",
+        L"wheel", L"when", L"where", L"whip", L"whisper", L"wide", L"width", L"wife",
+        L"wild", L"will", L"win", L"window", L"wine", L"wing", L"wink", L"winner",
+        L"winter", L"wire", L"wisdom", L"wise", L"wish", L"witness", L"wolf", L"woman",
+        L"wonder", L"wood", L"wool", L"word", L"work", L"world", L"worry", L"worth",
+        L"wrap", L"wreck", L"wrestle", L"wrist", L"write", L"wrong", L"yard", L"year",
+        L"yellow", L"you", L"young", L"youth", L"zebra", L"zero", L"zone", L"zoo"
+    };
+}
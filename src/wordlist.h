@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace passgen {
+    // The BIP-39 English wordlist: 2048 lowercase words of 3-8 letters,
+    // sorted, each identified by its first four letters. A power of two, so
+    // every word is exactly 11 bits.
+    const size_t kWordCount = 2048;
+    extern const wchar_t* const kWords[kWordCount];
+}
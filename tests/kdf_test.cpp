@@ -0,0 +1,74 @@
+#include "kdf.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    int failures = 0;
+
+    void Expect(const char* name, bool ok, const unsigned char* got, const unsigned char* want, size_t len) {
+        if (ok && memcmp(got, want, len) == 0) {
+            printf("ok   %s\n", name);
+            return;
+        }
+        ++failures;
+        printf("FAIL %s:", name);
+        for (size_t i = 0; ok && i < len; ++i) printf("%02x", got[i]);
+        printf("\n");
+    }
+
+    // RFC 9106 section 5.3: every input, including the secret and the
+    // associated data, is a run of one repeated byte.
+    void Rfc9106() {
+        unsigned char password[32], salt[16], secret[8], data[12], out[32];
+        memset(password, 0x01, sizeof(password));
+        memset(salt, 0x02, sizeof(salt));
+        memset(secret, 0x03, sizeof(secret));
+        memset(data, 0x04, sizeof(data));
+        kdf::Argon2Params p;
+        p.passes = 3;
+        p.memoryKiB = 32;
+        p.lanes = 4;
+        const unsigned char want[32] = {
+            0x0d, 0x64, 0x0d, 0xf5, 0x8d, 0x78, 0x76, 0x6c, 0x08, 0xc0, 0x37, 0xa3, 0x4a, 0x8b, 0x53, 0xc9,
+            0xd0, 0x1e, 0xf0, 0x45, 0x2d, 0x75, 0xb6, 0x5e, 0xb5, 0x25, 0x20, 0xe9, 0x6b, 0x01, 0xe6, 0x59
+        };
+        bool ok = kdf::Argon2id(password, sizeof(password), salt, sizeof(salt), p, out, sizeof(out),
+            secret, sizeof(secret), data, sizeof(data));
+        Expect("rfc9106 5.3", ok, out, want, sizeof(want));
+    }
+
+    // The reference implementation's test suite, without secret or
+    // associated data, as vault keys are derived. 64 MiB, one lane.
+    void Reference() {
+        kdf::Argon2Params p;
+        p.passes = 2;
+        p.memoryKiB = 64 * 1024;
+        p.lanes = 1;
+        const unsigned char want[32] = {
+            0x09, 0x31, 0x61, 0x15, 0xd5, 0xcf, 0x24, 0xed, 0x5a, 0x15, 0xa3, 0x1a, 0x3b, 0xa3, 0x26, 0xe5,
+            0xcf, 0x32, 0xed, 0xc2, 0x47, 0x02, 0x98, 0x7c, 0x02, 0xb6, 0x56, 0x6f, 0x61, 0x91, 0x3c, 0xf7
+        };
+        unsigned char out[32];
+        bool ok = kdf::Argon2id("password", 8, "somesalt", 8, p, out, sizeof(out));
+        Expect("reference t=2 m=64MiB p=1", ok, out, want, sizeof(want));
+    }
+
+    void Rejects() {
+        unsigned char out[32];
+        kdf::Argon2Params p;
+        p.passes = 1;
+        p.memoryKiB = 8;
+        p.lanes = 2;
+        const bool ok = !kdf::Argon2id("password", 8, "somesalt", 8, p, out, sizeof(out));
+        if (!ok) ++failures;
+        printf("%s memory below 8 KiB per lane\n", ok ? "ok  " : "FAIL");
+    }
+}
+
+int main() {
+    Rfc9106();
+    Reference();
+    Rejects();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include "match.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+
+// Runs every supported scanner on random mixed-case haystacks at every
+// length up to kMaxLen and checks each against a fold-then-find reference.
+namespace {
+    const size_t kMaxLen = 80;
+    const int kRounds = 400;
+
+    // Letters with several case forms, Latin, Cyrillic and Greek, and a few
+    // that fold to themselves, including one outside the fold table.
+    const wchar_t kAlphabet[] = L"aAbBzZ0 -ёЁжЖяЯσΣςéÉ中";
+
+    const search::Scanner kScanners[] = { search::Scanner::kScalar, search::Scanner::kSse2, search::Scanner::kAvx2 };
+    const char* const kNames[] = { "scalar", "sse2", "avx2" };
+
+    const size_t kLetters = sizeof(kAlphabet) / sizeof(kAlphabet[0]) - 1;
+
+    std::wstring Random(std::mt19937& rng, size_t len) {
+        std::wstring out;
+        for (size_t i = 0; i < len; ++i) out.push_back(kAlphabet[rng() % kLetters]);
+        return out;
+    }
+
+    // Folds as it goes and tries every start.
+    bool Reference(const std::wstring& hay, const std::wstring& folded) {
+        for (size_t i = 0; i + folded.size() <= hay.size(); ++i) {
+            size_t k = 0;
+            while (k < folded.size() && search::Fold(hay[i + k]) == folded[k]) ++k;
+            if (k == folded.size()) return true;
+        }
+        return false;
+    }
+
+    // A needle taken from the haystack with each letter swapped for a
+    // random form that folds the same, or an unrelated one that mostly
+    // misses.
+    std::wstring Needle(std::mt19937& rng, const std::wstring& hay) {
+        if (hay.empty() || rng() % 4 == 0) return Random(rng, 1 + rng() % 4);
+        size_t at = rng() % hay.size();
+        size_t len = 1 + rng() % std::min<size_t>(8, hay.size() - at);
+        std::wstring out = hay.substr(at, len);
+        for (auto& c : out) {
+            std::wstring forms;
+            for (size_t i = 0; i < kLetters; ++i) {
+                if (search::Fold(kAlphabet[i]) == search::Fold(c)) forms.push_back(kAlphabet[i]);
+            }
+            c = forms[rng() % forms.size()];
+        }
+        return out;
+    }
+}
+
+int main() {
+    std::mt19937 rng(12);
+    int failures = 0;
+    size_t checks = 0;
+    for (int s = 0; s < 3; ++s) {
+        if (!search::Supported(kScanners[s])) printf("skip %s: not supported here\n", kNames[s]);
+    }
+    for (int round = 0; round < kRounds && failures < 10; ++round) {
+        for (size_t len = 0; len <= kMaxLen && failures < 10; ++len) {
+            const std::wstring hay = Random(rng, len);
+            const std::wstring needle = Needle(rng, hay);
+            const search::Pattern pattern(needle);
+            const bool want = Reference(hay, pattern.Folded());
+            for (int s = 0; s < 3; ++s) {
+                if (!search::Supported(kScanners[s])) continue;
+                ++checks;
+                if (search::ContainsWith(kScanners[s], hay.data(), hay.size(), pattern) != want) {
+                    ++failures;
+                    printf("FAIL %s: length %zu, needle length %zu, want %d\n", kNames[s], len, needle.size(), want);
+                }
+            }
+        }
+    }
+    if (failures == 0) printf("ok   %zu scanner checks\n", checks);
+    return failures == 0 ? 0 : 1;
+}